@@ -0,0 +1,130 @@
+#include "apsp.h"
+#include <pthread.h>
+
+size_t apsp_stride(size_t n) {
+  return (n + APSP_BLOCK - 1) / APSP_BLOCK * APSP_BLOCK;
+}
+
+// c[j] = min(c[j], a + b[j]) over one row of a tile.
+// Rows of different tiles never overlap, and a row relaxed through itself
+// cannot improve since a >= 0, so c and b are distinct. The loop then
+// compiles to packed adds and mins.
+static inline void min_plus_row(double *restrict c, double a, const double *restrict b) {
+  for (size_t j = 0; j < APSP_BLOCK; j++) {
+    double alt = a + b[j];
+    c[j] = alt < c[j] ? alt : c[j];
+  }
+}
+
+// Relaxes tile c through tiles a (rows of c, columns k) and b (rows k,
+// columns of c). With no negative weights, row and column k do not change
+// while k is the intermediate vertex, so the tiles may alias.
+static void min_plus_tile(double *c, const double *a, const double *b, size_t stride) {
+  for (size_t k = 0; k < APSP_BLOCK; k++) {
+    for (size_t i = 0; i < APSP_BLOCK; i++) {
+      double aik = a[i * stride + k];
+      if (aik >= INF || &c[i * stride] == &b[k * stride]) continue;
+      min_plus_row(&c[i * stride], aik, &b[k * stride]);
+    }
+  }
+}
+
+// Tiles of one round handled by a thread
+typedef struct fw_task {
+  double *dist;
+  size_t stride;
+  // tiles per row
+  size_t nblocks;
+  // pivot tile index
+  size_t kb;
+  // 1 for the pivot's row and column, 2 for the remaining tiles
+  int phase;
+  // this thread takes every nthreads-th tile starting at first
+  size_t first;
+  size_t nthreads;
+} fw_task;
+
+static double *tile(double *dist, size_t stride, size_t ib, size_t jb) {
+  return &dist[ib * APSP_BLOCK * stride + jb * APSP_BLOCK];
+}
+
+static void *fw_worker(void *arg) {
+  fw_task *t = arg;
+  size_t nb = t->nblocks, kb = t->kb, stride = t->stride;
+  double *pivot = tile(t->dist, stride, kb, kb);
+
+  if (t->phase == 1) {
+    // tiles sharing a row or a column with the pivot
+    for (size_t x = t->first; x < nb; x += t->nthreads) {
+      if (x == kb) continue;
+      double *row = tile(t->dist, stride, kb, x);
+      double *col = tile(t->dist, stride, x, kb);
+      min_plus_tile(row, pivot, row, stride);
+      min_plus_tile(col, col, pivot, stride);
+    }
+  } else {
+    // every other tile, through the updated row and column
+    for (size_t ib = t->first; ib < nb; ib += t->nthreads) {
+      if (ib == kb) continue;
+      for (size_t jb = 0; jb < nb; jb++) {
+        if (jb == kb) continue;
+        min_plus_tile(tile(t->dist, stride, ib, jb), tile(t->dist, stride, ib, kb),
+            tile(t->dist, stride, kb, jb), stride);
+      }
+    }
+  }
+  return NULL;
+}
+
+// Runs one phase of round kb on nthreads threads
+static void fw_phase(double *dist, size_t stride, size_t kb, int phase, size_t nthreads) {
+  size_t nb = stride / APSP_BLOCK;
+  fw_task *tasks = calloc(nthreads, sizeof(fw_task));
+  pthread_t *threads = calloc(nthreads, sizeof(pthread_t));
+  assert(tasks && threads);
+
+  for (size_t i = 0; i < nthreads; i++) {
+    tasks[i] = (fw_task) {dist, stride, nb, kb, phase, i, nthreads};
+  }
+  for (size_t i = 1; i < nthreads; i++) {
+    int err = pthread_create(&threads[i], NULL, fw_worker, &tasks[i]);
+    assert(err == 0);
+    (void) err;
+  }
+  fw_worker(&tasks[0]);
+  for (size_t i = 1; i < nthreads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  free(tasks);
+  free(threads);
+}
+
+void floyd_warshall(graph *g, double dist[], size_t nthreads) {
+  assert(g);
+  assert(dist);
+  size_t n = g->nvertices;
+  size_t stride = apsp_stride(n);
+  size_t nb = stride / APSP_BLOCK;
+  if (nthreads == 0) nthreads = 1;
+  if (nthreads > nb) nthreads = nb;
+
+  for (size_t i = 0; i < stride * stride; i++) {
+    dist[i] = INF;
+  }
+  for (size_t v = 0; v < n; v++) {
+    dist[v * stride + v] = 0;
+    for (edgenode *p = g->edges[v]; p; p = p->next) {
+      if (p->weight < dist[v * stride + p->y]) {
+        dist[v * stride + p->y] = p->weight;
+      }
+    }
+  }
+
+  for (size_t kb = 0; kb < nb; kb++) {
+    double *pivot = tile(dist, stride, kb, kb);
+    min_plus_tile(pivot, pivot, pivot, stride);
+    fw_phase(dist, stride, kb, 1, nthreads);
+    fw_phase(dist, stride, kb, 2, nthreads);
+  }
+}
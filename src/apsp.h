@@ -0,0 +1,24 @@
+#pragma once
+
+#include "graph.h"
+
+// Side of the square tiles Floyd-Warshall works on.
+// A tile of doubles is 32 KiB, three of them fit in L2.
+#define APSP_BLOCK 64
+// Edge density (edges / possible edges) from which the distance
+// distribution of a graph with integer weights uses floyd_warshall()
+// over repeated searches
+#define APSP_DENSITY 0.05
+// Largest graph the dense matrix is built for (128 MiB of distances)
+#define APSP_MAX_VERTICES 4096
+
+// Row stride and row count of the distance matrix of an n vertex graph:
+// n rounded up to a multiple of APSP_BLOCK
+size_t apsp_stride(size_t n);
+
+// All-pairs shortest distances by cache-blocked Floyd-Warshall.
+// dist holds apsp_stride(n) * apsp_stride(n) entries and receives
+// d(i, j) at dist[i * apsp_stride(n) + j], INF if j is unreachable.
+// Tiles of each round are split among nthreads threads.
+// Weights must not be negative.
+void floyd_warshall(graph *g, double dist[], size_t nthreads);
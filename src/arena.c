@@ -0,0 +1,110 @@
+#include "arena.h"
+
+static inline size_t round_up(size_t n) {
+  return (n + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1);
+}
+
+// size class of a rounded size, ARENA_CLASSES if it has none
+static inline size_t size_class(size_t n) {
+  size_t c = n / ARENA_ALIGN - 1;
+  return c < ARENA_CLASSES ? c : ARENA_CLASSES;
+}
+
+static arena_block *arena_new_block(arena *a, size_t size) {
+  arena_block *b = malloc(sizeof(arena_block) + size);
+  assert(b);
+  b->size = size;
+  b->used = 0;
+  a->reserved += size;
+  return b;
+}
+
+arena *arena_init(arena *a, size_t block_size) {
+  assert(a);
+
+  a->blocks = NULL;
+  a->block_size = block_size ? round_up(block_size) : ARENA_DEFAULT_BLOCK;
+  for (size_t i = 0; i < ARENA_CLASSES; i++) {
+    a->free_lists[i] = NULL;
+  }
+  a->allocated = 0;
+  a->reserved = 0;
+
+  return a;
+}
+
+void arena_destroy(arena *a) {
+  assert(a);
+
+  arena_block *b = a->blocks;
+  while (b) {
+    arena_block *next = b->next;
+    free(b);
+    b = next;
+  }
+
+  arena_init(a, a->block_size);
+}
+
+void *arena_alloc(arena *a, size_t n) {
+  assert(a);
+
+  n = round_up(n ? n : 1);
+  a->allocated += n;
+
+  // reuse a freed chunk
+  size_t c = size_class(n);
+  if (c < ARENA_CLASSES && a->free_lists[c]) {
+    void *p = a->free_lists[c];
+    a->free_lists[c] = *(void **) p;
+    return p;
+  }
+
+  // large requests get a dedicated block, linked behind the current one
+  // so the bump pointer is not lost
+  if (n > a->block_size / 4) {
+    arena_block *b = arena_new_block(a, n);
+    b->used = n;
+    if (a->blocks) {
+      b->next = a->blocks->next;
+      a->blocks->next = b;
+    } else {
+      b->next = NULL;
+      a->blocks = b;
+    }
+    return b->data;
+  }
+
+  // bump allocation
+  arena_block *b = a->blocks;
+  if (!b || b->size - b->used < n) {
+    b = arena_new_block(a, a->block_size);
+    b->next = a->blocks;
+    a->blocks = b;
+  }
+
+  void *p = b->data + b->used;
+  b->used += n;
+  return p;
+}
+
+void *arena_calloc(arena *a, size_t count, size_t size) {
+  assert(size == 0 || count <= SIZE_MAX / size);
+  void *p = arena_alloc(a, count * size);
+  memset(p, 0, count * size);
+  return p;
+}
+
+void arena_free(arena *a, void *ptr, size_t n) {
+  assert(a);
+  if (!ptr) return;
+
+  n = round_up(n ? n : 1);
+  a->allocated -= n;
+
+  size_t c = size_class(n);
+  if (c < ARENA_CLASSES) {
+    *(void **) ptr = a->free_lists[c];
+    a->free_lists[c] = ptr;
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+// Default size of an arena block
+#define ARENA_DEFAULT_BLOCK (1 << 20)
+// Allocation granularity, every allocation is aligned to it.
+// Enough for the pointer and scalar types stored by the containers.
+#define ARENA_ALIGN 8
+// Number of size classes with free lists (ARENA_ALIGN, 2 * ARENA_ALIGN, ...)
+#define ARENA_CLASSES 16
+
+typedef struct arena_block {
+  struct arena_block *next;
+  // usable bytes in data
+  size_t size;
+  // bytes handed out from data
+  size_t used;
+  // padding keeps data 16-byte aligned
+  size_t pad;
+  unsigned char data[];
+} arena_block;
+
+typedef struct arena {
+  // blocks, most recent first
+  arena_block *blocks;
+  // size of newly allocated blocks
+  size_t block_size;
+  // freed chunks, one list per size class
+  void *free_lists[ARENA_CLASSES];
+  // bytes currently handed out
+  size_t allocated;
+  // bytes reserved from the system
+  size_t reserved;
+} arena;
+
+// Initializes arena a with blocks of block_size bytes
+// (ARENA_DEFAULT_BLOCK if 0). No memory is reserved until the first allocation.
+arena *arena_init(arena *a, size_t block_size);
+
+// Releases every block of a at once
+void arena_destroy(arena *a);
+
+// Returns n bytes from a, reusing a freed chunk of the same size class
+// when there is one. Requests larger than a block get a block of their own.
+void *arena_alloc(arena *a, size_t n);
+
+// Same as arena_alloc, but the memory is zeroed
+void *arena_calloc(arena *a, size_t count, size_t size);
+
+// Returns a chunk of n bytes obtained from a to its size class free list.
+// Chunks too large for a size class are only reclaimed by arena_destroy().
+void arena_free(arena *a, void *ptr, size_t n);
+
+// Allocates from a if it is not NULL, from the system allocator otherwise.
+// Containers that may or may not be backed by an arena use these.
+static inline void *arena_or_calloc(arena *a, size_t size) {
+  return a ? arena_calloc(a, 1, size) : calloc(1, size);
+}
+
+static inline void arena_or_free(arena *a, void *ptr, size_t size) {
+  if (a) {
+    arena_free(a, ptr, size);
+  } else {
+    free(ptr);
+  }
+}
@@ -0,0 +1,530 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include "list.h"
+#include "mpmc_queue.h"
+#include "graph.h"
+#include "graph_io.h"
+#include "ch.h"
+#include "reorder.h"
+#include "compact.h"
+#include "packed.h"
+
+// Benchmark harness. Each benchmark reads its own arguments.
+typedef struct benchmark {
+  const char *name;
+  const char *usage;
+  int (*run)(int argc, const char *argv[]);
+} benchmark;
+
+// Monotonic clock in seconds
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+// Queue contention
+
+typedef enum { Q_MPMC, Q_SEGMENTED, Q_LOCKED_LIST } queue_kind;
+
+typedef struct queue_bench {
+  queue_kind kind;
+  mpmc_queue mpmc;
+  seg_queue seg;
+  List *list;
+  pthread_mutex_t lock;
+  // items each producer pushes
+  size_t per_producer;
+  // items still to be consumed
+  atomic_size_t remaining;
+  // sum of consumed items, checked against the expected total
+  atomic_size_t checksum;
+} queue_bench;
+
+static void qb_push(queue_bench *b, size_t x) {
+  switch (b->kind) {
+  case Q_MPMC:
+    while (!mpmc_push(&b->mpmc, &x)) {
+      sched_yield();
+    }
+    break;
+  case Q_SEGMENTED:
+    sq_push(&b->seg, &x);
+    break;
+  case Q_LOCKED_LIST:
+    pthread_mutex_lock(&b->lock);
+    append(b->list, &x);
+    pthread_mutex_unlock(&b->lock);
+    break;
+  }
+}
+
+static bool qb_pop(queue_bench *b, size_t *x) {
+  switch (b->kind) {
+  case Q_MPMC:
+    return mpmc_pop(&b->mpmc, x);
+  case Q_SEGMENTED:
+    return sq_pop(&b->seg, x);
+  case Q_LOCKED_LIST: {
+    pthread_mutex_lock(&b->lock);
+    bool found = !isEmpty(b->list);
+    removeFirst(b->list, x);
+    pthread_mutex_unlock(&b->lock);
+    return found;
+  }
+  }
+  return false;
+}
+
+static void *qb_producer(void *arg) {
+  queue_bench *b = arg;
+  for (size_t i = 1; i <= b->per_producer; i++) {
+    qb_push(b, i);
+  }
+  return NULL;
+}
+
+static void *qb_consumer(void *arg) {
+  queue_bench *b = arg;
+  size_t sum = 0;
+  while (atomic_load(&b->remaining) > 0) {
+    size_t x;
+    if (qb_pop(b, &x)) {
+      sum += x;
+      atomic_fetch_sub(&b->remaining, 1);
+    } else {
+      sched_yield();
+    }
+  }
+  atomic_fetch_add(&b->checksum, sum);
+  return NULL;
+}
+
+// Runs 'threads' producers and as many consumers moving 'items' elements.
+// Returns millions of elements per second.
+static double queue_run(queue_kind kind, size_t threads, size_t items) {
+  queue_bench b;
+  b.kind = kind;
+  b.per_producer = items / threads;
+  atomic_init(&b.remaining, b.per_producer * threads);
+  atomic_init(&b.checksum, 0);
+
+  switch (kind) {
+  case Q_MPMC:
+    mpmc_init(&b.mpmc, sizeof(size_t), 1024);
+    break;
+  case Q_SEGMENTED:
+    sq_init(&b.seg, sizeof(size_t), 0);
+    break;
+  case Q_LOCKED_LIST:
+    b.list = initList(free, sizeof(size_t));
+    pthread_mutex_init(&b.lock, NULL);
+    break;
+  }
+
+  pthread_t *tids = calloc(2 * threads, sizeof(pthread_t));
+  double start = now();
+  for (size_t t = 0; t < threads; t++) {
+    pthread_create(&tids[t], NULL, qb_producer, &b);
+    pthread_create(&tids[threads + t], NULL, qb_consumer, &b);
+  }
+  for (size_t t = 0; t < 2 * threads; t++) {
+    pthread_join(tids[t], NULL);
+  }
+  double elapsed = now() - start;
+  free(tids);
+
+  size_t expected = threads * b.per_producer * (b.per_producer + 1) / 2;
+  if (atomic_load(&b.checksum) != expected) {
+    fprintf(stderr, "queue benchmark: checksum mismatch\n");
+    exit(EXIT_FAILURE);
+  }
+
+  switch (kind) {
+  case Q_MPMC:
+    mpmc_destroy(&b.mpmc);
+    break;
+  case Q_SEGMENTED:
+    sq_destroy(&b.seg);
+    break;
+  case Q_LOCKED_LIST:
+    deinitList(b.list);
+    pthread_mutex_destroy(&b.lock);
+    break;
+  }
+
+  return (double) (threads * b.per_producer) / elapsed * 1e-6;
+}
+
+static int bench_queue(int argc, const char *argv[]) {
+  size_t max_threads = argc > 0 ? (size_t) atoi(argv[0]) : 8;
+  size_t items = argc > 1 ? (size_t) atol(argv[1]) : 2000000;
+  if (max_threads == 0 || items == 0) {
+    printf("Invalid arguments. Exiting.\n");
+    return EXIT_FAILURE;
+  }
+
+  printf("%8s %14s %14s %14s\n", "threads", "mpmc Mops/s", "segment Mops/s", "list Mops/s");
+  for (size_t t = 1; t <= max_threads; t *= 2) {
+    double mpmc = queue_run(Q_MPMC, t, items);
+    double seg = queue_run(Q_SEGMENTED, t, items);
+    double list = queue_run(Q_LOCKED_LIST, t, items);
+    printf("%8zu %14.2f %14.2f %14.2f\n", t, mpmc, seg, list);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// Contraction hierarchies
+
+static int bench_ch(int argc, const char *argv[]) {
+  if (argc < 1) {
+    printf("Insufficient arguments supplied. Please supply an input graph.\n");
+    return EXIT_FAILURE;
+  }
+  size_t queries = argc > 1 ? (size_t) atol(argv[1]) : 100;
+
+  graph *g = read_graph(argv[0], calloc(1, sizeof(graph)));
+  size_t n = g->nvertices;
+
+  const char *reason = NULL;
+  if (!ch_suitable(g, &reason)) {
+    printf("Contraction hierarchy not built: %s.\n", reason);
+    destroy_graph(g);
+    free(g);
+    return EXIT_SUCCESS;
+  }
+
+  contraction_hierarchy ch;
+  double start = now();
+  ch_build(&ch, g);
+  double preprocess = now() - start;
+
+  double *dist = calloc(n, sizeof(double));
+  double *ch_dist = calloc(n, sizeof(double));
+  int *prev = calloc(n, sizeof(int));
+
+  // the same random pairs for both searches
+  srand(1);
+  double dijkstra_time = 0, ch_time = 0;
+  size_t settled = 0, mismatches = 0;
+  for (size_t q = 0; q < queries; q++) {
+    size_t s = (size_t) rand() % n;
+    size_t t = (size_t) rand() % n;
+
+    start = now();
+    dijkstra(g, s, dist, prev);
+    dijkstra_time += now() - start;
+
+    start = now();
+    double d = ch_query(&ch, s, t, ch_dist, prev);
+    ch_time += now() - start;
+    settled += ch.settled;
+
+    if (d != dist[t]) {
+      mismatches++;
+    }
+  }
+
+  printf("vertices: %zu\n", n);
+  // nedges counts both directions of an undirected edge
+  printf("edges: %zu\n", g->directed ? g->nedges : g->nedges / 2);
+  printf("preprocess: %.3f s\n", preprocess);
+  printf("shortcuts: %zu\n", ch.nshortcuts);
+  printf("dijkstra query: %.3f ms\n", dijkstra_time / (double) queries * 1e3);
+  printf("ch query: %.3f ms\n", ch_time / (double) queries * 1e3);
+  printf("speedup: %.1fx\n", dijkstra_time / ch_time);
+  printf("settled per ch query: %.1f\n", (double) settled / (double) queries);
+  printf("mismatches: %zu\n", mismatches);
+
+  free(dist);
+  free(ch_dist);
+  free(prev);
+  ch_destroy(&ch);
+  destroy_graph(g);
+  free(g);
+
+  return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Vertex orderings
+
+static int bench_order(int argc, const char *argv[]) {
+  if (argc < 1) {
+    printf("Insufficient arguments supplied. Please supply an input graph.\n");
+    return EXIT_FAILURE;
+  }
+  size_t sources = argc > 1 ? (size_t) atol(argv[1]) : 20;
+
+  const char *names[] = {"none", "rcm", "degree", "bfs"};
+  const vertex_order kinds[] = {ORDER_NONE, ORDER_RCM, ORDER_DEGREE, ORDER_BFS};
+
+  printf("%-8s %12s %10s %14s %10s\n", "order", "relabel ms", "avg span", "dijkstra ms", "prim ms");
+  for (size_t o = 0; o < sizeof(kinds) / sizeof(kinds[0]); o++) {
+    graph *g = read_graph(argv[0], calloc(1, sizeof(graph)));
+    size_t n = g->nvertices;
+
+    double start = now();
+    reorder_graph(g, kinds[o]);
+    double relabel = now() - start;
+
+    // average distance between the ids of an edge's endpoints
+    double span = 0;
+    for (size_t v = 0; v < n; v++) {
+      for (edgenode *p = g->edges[v]; p; p = p->next) {
+        span += p->y > v ? (double) (p->y - v) : (double) (v - p->y);
+      }
+    }
+    // nedges already counts both directions of an undirected edge
+    span /= (double) g->nedges;
+
+    double *dist = calloc(n, sizeof(double));
+    int *prev = calloc(n, sizeof(int));
+    double *keys = calloc(n, sizeof(double));
+
+    // the same original sources for every order
+    start = now();
+    for (size_t i = 0; i < sources; i++) {
+      dijkstra(g, graph_vertex(g, i * 7919 % n), dist, prev);
+    }
+    double search = (now() - start) / (double) sources;
+
+    start = now();
+    prim(g, prev, keys);
+    double tree = now() - start;
+
+    printf("%-8s %12.3f %10.1f %14.3f %10.3f\n", names[o],
+        relabel * 1e3, span, search * 1e3, tree * 1e3);
+
+    free(dist);
+    free(prev);
+    free(keys);
+    destroy_graph(g);
+    free(g);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// Graph loading
+
+static int bench_load(int argc, const char *argv[]) {
+  if (argc < 1) {
+    printf("Insufficient arguments supplied. Please supply an input graph.\n");
+    return EXIT_FAILURE;
+  }
+  size_t max_threads = argc > 1 ? (size_t) atol(argv[1]) : 4;
+
+  graph *g = calloc(1, sizeof(graph));
+  double start = now();
+  read_graph(argv[0], g);
+  double sequential = now() - start;
+  uint64_t expected = graph_fingerprint(g);
+  printf("vertices: %zu, edges: %zu\n", g->nvertices, g->directed ? g->nedges : g->nedges / 2);
+  printf("%-16s %10.3f s\n", "read_graph", sequential);
+  destroy_graph(g);
+
+  bool same = true;
+  for (size_t t = 1; t <= max_threads; t *= 2) {
+    start = now();
+    load_graph(argv[0], g, t);
+    double elapsed = now() - start;
+    printf("load_graph %2zu    %10.3f s  %5.1fx\n", t, elapsed, sequential / elapsed);
+    same = same && graph_fingerprint(g) == expected;
+    destroy_graph(g);
+  }
+  free(g);
+
+  printf("identical: %s\n", same ? "yes" : "no");
+  return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Spanning trees
+
+static int bench_prim(int argc, const char *argv[]) {
+  if (argc < 1) {
+    printf("Insufficient arguments supplied. Please supply an input graph.\n");
+    return EXIT_FAILURE;
+  }
+  size_t rounds = argc > 1 ? (size_t) atol(argv[1]) : 5;
+
+  graph *g = load_graph(argv[0], calloc(1, sizeof(graph)), 1);
+  size_t n = g->nvertices;
+  printf("vertices: %zu, density: %.3f\n", n, graph_density(g));
+
+  int *parents = calloc(n, sizeof(int));
+  double *keys = calloc(n, sizeof(double));
+  double heap_cost = 0.0, dense_cost = 0.0;
+  size_t root = graph_vertex(g, 0);
+
+  double start = now();
+  for (size_t r = 0; r < rounds; r++) {
+    prim(g, parents, keys);
+  }
+  double heap = (now() - start) / (double) rounds;
+  for (size_t v = 0; v < n; v++) {
+    if (parents[v] != -1) heap_cost += keys[v];
+  }
+
+  start = now();
+  for (size_t r = 0; r < rounds; r++) {
+    prim_dense(g, &root, 1, parents, keys);
+  }
+  double dense = (now() - start) / (double) rounds;
+  for (size_t v = 0; v < n; v++) {
+    if (parents[v] != -1) dense_cost += keys[v];
+  }
+
+  printf("%-12s %10.3f ms\n", "heap", heap * 1e3);
+  printf("%-12s %10.3f ms  %5.1fx\n", "dense", dense * 1e3, heap / dense);
+  printf("same cost: %s\n", heap_cost == dense_cost ? "yes" : "no");
+
+  free(parents);
+  free(keys);
+  destroy_graph(g);
+  free(g);
+  return heap_cost == dense_cost ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Edge layouts
+
+static int bench_packed(int argc, const char *argv[]) {
+  if (argc < 1) {
+    printf("Insufficient arguments supplied. Please supply an input graph.\n");
+    return EXIT_FAILURE;
+  }
+  size_t sources = argc > 1 ? (size_t) atol(argv[1]) : 20;
+
+  const char *names[] = {"lists", "compact", "packed"};
+  graph *graphs[3];
+  for (size_t l = 0; l < 3; l++) {
+    graphs[l] = load_graph(argv[0], calloc(1, sizeof(graph)), 1);
+    const char *reason = NULL;
+    bool stored = l == 0 || (l == 1 ? compact_graph(graphs[l], &reason) : packed_graph(graphs[l], &reason));
+    if (!stored) {
+      printf("Cannot store the graph compactly: %s.\n", reason);
+      return EXIT_FAILURE;
+    }
+  }
+  size_t n = graphs[0]->nvertices;
+  size_t total = graphs[2]->packed->offsets[n];
+  printf("vertices: %zu, adjacency entries: %zu\n", n, total);
+
+  // decode every list with both decoders, which must agree
+  const packed_edges *p = graphs[2]->packed;
+  uint32_t *a = calloc(p->width, sizeof(uint32_t));
+  uint32_t *b = calloc(p->width, sizeof(uint32_t));
+  bool same_targets = true;
+  for (size_t v = 0; v < n; v++) {
+    size_t d = packed_decode_scalar(p, v, a);
+    packed_decode(p, v, b);
+    same_targets = same_targets && memcmp(a, b, d * sizeof(uint32_t)) == 0;
+  }
+  uint64_t sum = 0;
+  double start = now();
+  for (size_t v = 0; v < n; v++) {
+    sum += packed_decode_scalar(p, v, a) ? a[0] : 0;
+  }
+  double scalar = now() - start;
+  start = now();
+  for (size_t v = 0; v < n; v++) {
+    sum += packed_decode(p, v, b) ? b[0] : 0;
+  }
+  double simd = now() - start;
+  free(a);
+  free(b);
+
+  double *dist = calloc(n, sizeof(double));
+  int *prev = calloc(n, sizeof(int));
+  double *keys = calloc(n, sizeof(double));
+  // per layout: edge bytes, search and tree time, reached distances and cost
+  double bytes[3], search[3], tree[3], dists[3], cost[3];
+
+  for (size_t l = 0; l < 3; l++) {
+    graph *g = graphs[l];
+    bytes[l] = (double) graph_edge_bytes(g);
+
+    dists[l] = 0.0;
+    start = now();
+    for (size_t i = 0; i < sources; i++) {
+      dijkstra(g, i * 7919 % n, dist, prev);
+      for (size_t v = 0; v < n; v++) {
+        if (dist[v] < INF) dists[l] += dist[v];
+      }
+    }
+    search[l] = (now() - start) / (double) sources;
+
+    priority_queue *pq = pq_init(calloc(1, sizeof(priority_queue)), n + 1);
+    start = now();
+    prim_pq(g, prev, keys, pq);
+    tree[l] = now() - start;
+    pq_destroy(pq);
+    free(pq);
+    cost[l] = 0.0;
+    for (size_t v = 0; v < n; v++) {
+      if (prev[v] != -1) cost[l] += keys[v];
+    }
+  }
+
+  printf("%-8s %12s %10s %7s %14s %10s\n", "layout", "edge bytes", "bytes/edge", "ratio",
+      "dijkstra ms", "prim ms");
+  for (size_t l = 0; l < 3; l++) {
+    printf("%-8s %12.0f %10.2f %6.1fx %14.3f %10.3f\n", names[l], bytes[l],
+        bytes[l] / (double) total, bytes[0] / bytes[l], search[l] * 1e3, tree[l] * 1e3);
+  }
+  printf("decode scalar: %8.1f M entries/s\n", (double) total / scalar * 1e-6);
+  printf("decode simd: %10.1f M entries/s  %5.1fx\n", (double) total / simd * 1e-6, scalar / simd);
+  printf("packed over compact: dijkstra %.2fx, prim %.2fx\n",
+      search[2] / search[1], tree[2] / tree[1]);
+
+  bool same_dist = dists[1] == dists[0] && dists[2] == dists[0];
+  bool same_cost = cost[1] == cost[0] && cost[2] == cost[0];
+  printf("same targets: %s, distances: %s, cost: %s\n",
+      same_targets ? "yes" : "no", same_dist ? "yes" : "no", same_cost ? "yes" : "no");
+  // keeps the timed decodes from being optimized away
+  if (sum == 1) printf("\n");
+
+  free(dist);
+  free(prev);
+  free(keys);
+  for (size_t l = 0; l < 3; l++) {
+    destroy_graph(graphs[l]);
+    free(graphs[l]);
+  }
+  return same_targets && same_dist && same_cost ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static const benchmark benchmarks[] = {
+  {"queue", "queue [max threads] [items]", bench_queue},
+  {"ch", "ch input [queries]", bench_ch},
+  {"order", "order input [sources]", bench_order},
+  {"load", "load input [max threads]", bench_load},
+  {"prim", "prim input [rounds]", bench_prim},
+  {"packed", "packed input [sources]", bench_packed},
+};
+
+int main(int argc, const char *argv[]) {
+  size_t n = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+  if (argc < 2) {
+    printf("No benchmark supplied.\nUsage: %s benchmark [arguments]\n", argv[0]);
+    for (size_t i = 0; i < n; i++) {
+      printf("  %s %s\n", argv[0], benchmarks[i].usage);
+    }
+    exit(EXIT_FAILURE);
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    if (strcmp(argv[1], benchmarks[i].name) == 0) {
+      return benchmarks[i].run(argc - 2, argv + 2);
+    }
+  }
+
+  printf("Invalid benchmark '%s'\n", argv[1]);
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,257 @@
+#include "bfs.h"
+#include "stats.h"
+#include "compact.h"
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Bitmaps over the vertices, 64 vertices per word
+static inline bool bit_get(const _Atomic uint64_t *bits, size_t v) {
+  return (atomic_load_explicit(&bits[v / 64], memory_order_relaxed) >> (v % 64)) & 1;
+}
+
+static inline void bit_set(_Atomic uint64_t *bits, size_t v) {
+  atomic_fetch_or_explicit(&bits[v / 64], (uint64_t) 1 << (v % 64), memory_order_relaxed);
+}
+
+// Sets bit v and returns whether it was clear before
+static inline bool bit_claim(_Atomic uint64_t *bits, size_t v) {
+  uint64_t mask = (uint64_t) 1 << (v % 64);
+  if (atomic_load_explicit(&bits[v / 64], memory_order_relaxed) & mask) {
+    return false;
+  }
+  return !(atomic_fetch_or_explicit(&bits[v / 64], mask, memory_order_relaxed) & mask);
+}
+
+typedef struct bfs_state {
+  graph *g;
+  double *dist;
+  int *prev;
+  // vertices already reached
+  _Atomic uint64_t *visited;
+  // current and next frontier as bitmaps (bottom-up)
+  _Atomic uint64_t *front_bits;
+  _Atomic uint64_t *next_bits;
+  // current frontier as a list (top-down)
+  size_t *front;
+  size_t nfront;
+  // depth of the current frontier
+  double level;
+} bfs_state;
+
+// Work of one thread in a level
+typedef struct bfs_task {
+  bfs_state *s;
+  // share of the frontier (top-down) or of the vertices (bottom-up)
+  size_t begin;
+  size_t end;
+  // vertices discovered by this thread, kept across levels
+  size_t *found;
+  size_t nfound;
+  size_t capacity;
+  // edges out of discovered vertices
+  size_t found_edges;
+} bfs_task;
+
+static inline void found_push(bfs_task *t, size_t v) {
+  if (t->nfound == t->capacity) {
+    t->capacity = t->capacity ? 2 * t->capacity : 1024;
+    t->found = realloc(t->found, t->capacity * sizeof(size_t));
+    assert(t->found);
+  }
+  t->found[t->nfound++] = v;
+}
+
+static void *top_down_task(void *arg) {
+  bfs_task *t = arg;
+  bfs_state *s = t->s;
+
+  const compact_edges *c = s->g->compact;
+  for (size_t i = t->begin; i < t->end; i++) {
+    size_t u = s->front[i];
+    if (c) {
+      for (size_t e = c->offsets[u]; e < c->offsets[u + 1]; e++) {
+        STATS_COUNT(ST_RELAX);
+        size_t v = c->targets[e];
+        if (bit_claim(s->visited, v)) {
+          s->dist[v] = s->level + 1;
+          s->prev[v] = (int) u;
+          found_push(t, v);
+          t->found_edges += s->g->degree[v];
+        }
+      }
+      continue;
+    }
+    for (edgenode *p = s->g->edges[u]; p; p = p->next) {
+      STATS_COUNT(ST_RELAX);
+      size_t v = p->y;
+      if (bit_claim(s->visited, v)) {
+        s->dist[v] = s->level + 1;
+        s->prev[v] = (int) u;
+        found_push(t, v);
+        t->found_edges += s->g->degree[v];
+      }
+    }
+  }
+
+  return NULL;
+}
+
+// Ranges are multiples of 64 vertices, so every bitmap word is written by
+// a single thread
+static void *bottom_up_task(void *arg) {
+  bfs_task *t = arg;
+  bfs_state *s = t->s;
+
+  const compact_edges *c = s->g->compact;
+  for (size_t v = t->begin; v < t->end; v++) {
+    if (bit_get(s->visited, v)) continue;
+    if (c) {
+      for (size_t e = c->offsets[v]; e < c->offsets[v + 1]; e++) {
+        STATS_COUNT(ST_RELAX);
+        size_t y = c->targets[e];
+        if (bit_get(s->front_bits, y)) {
+          s->dist[v] = s->level + 1;
+          s->prev[v] = (int) y;
+          bit_set(s->visited, v);
+          bit_set(s->next_bits, v);
+          found_push(t, v);
+          t->found_edges += s->g->degree[v];
+          break;
+        }
+      }
+      continue;
+    }
+    for (edgenode *p = s->g->edges[v]; p; p = p->next) {
+      STATS_COUNT(ST_RELAX);
+      if (bit_get(s->front_bits, p->y)) {
+        s->dist[v] = s->level + 1;
+        s->prev[v] = (int) p->y;
+        bit_set(s->visited, v);
+        bit_set(s->next_bits, v);
+        found_push(t, v);
+        t->found_edges += s->g->degree[v];
+        break;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+// Runs fn over tasks[0..n), the calling thread taking the first one
+static void run_tasks(void *(*fn)(void *), bfs_task tasks[], size_t n) {
+  pthread_t *threads = n > 1 ? calloc(n, sizeof(pthread_t)) : NULL;
+  for (size_t i = 1; i < n; i++) {
+    int err = pthread_create(&threads[i], NULL, fn, &tasks[i]);
+    assert(err == 0);
+    (void) err;
+  }
+  fn(&tasks[0]);
+  for (size_t i = 1; i < n; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+}
+
+void bfs(graph *g, size_t source, double dist[], int prev[], size_t nthreads) {
+  assert(g);
+  assert(source < g->nvertices);
+  if (nthreads == 0) {
+    nthreads = 1;
+  }
+
+  size_t n = g->nvertices;
+  size_t words = (n + 63) / 64;
+
+  for (size_t i = 0; i < n; i++) {
+    dist[i] = INF;
+    prev[i] = -1;
+  }
+
+  bfs_state s;
+  s.g = g;
+  s.dist = dist;
+  s.prev = prev;
+  s.visited = calloc(words, sizeof(uint64_t));
+  s.front_bits = calloc(words, sizeof(uint64_t));
+  s.next_bits = calloc(words, sizeof(uint64_t));
+  s.front = calloc(n, sizeof(size_t));
+  assert(s.visited && s.front_bits && s.next_bits && s.front);
+
+  bfs_task *tasks = calloc(nthreads, sizeof(bfs_task));
+  assert(tasks);
+
+  dist[source] = 0;
+  bit_set(s.visited, source);
+  s.front[0] = source;
+  s.nfront = 1;
+  s.level = 0;
+
+  size_t front_edges = g->degree[source];
+  // edges out of vertices not yet reached; nedges counts the adjacency
+  // entries, both directions of an undirected edge
+  size_t unexplored_edges = g->nedges - front_edges;
+  bool bottom_up = false;
+
+  while (s.nfront > 0) {
+    // pick the direction of this step
+    if (!g->directed) {
+      if (!bottom_up && front_edges > unexplored_edges / BFS_ALPHA) {
+        bottom_up = true;
+      } else if (bottom_up && s.nfront < n / BFS_BETA) {
+        bottom_up = false;
+      }
+    }
+
+    size_t ntasks = nthreads;
+    if (bottom_up) {
+      // frontier as a bitmap
+      memset((void *) s.front_bits, 0, words * sizeof(uint64_t));
+      memset((void *) s.next_bits, 0, words * sizeof(uint64_t));
+      for (size_t i = 0; i < s.nfront; i++) {
+        bit_set(s.front_bits, s.front[i]);
+      }
+      // vertex ranges aligned to bitmap words
+      size_t chunk = (words + ntasks - 1) / ntasks * 64;
+      for (size_t t = 0; t < ntasks; t++) {
+        tasks[t].begin = t * chunk < n ? t * chunk : n;
+        tasks[t].end = tasks[t].begin + chunk < n ? tasks[t].begin + chunk : n;
+      }
+    } else {
+      // frontier ranges
+      size_t chunk = (s.nfront + ntasks - 1) / ntasks;
+      for (size_t t = 0; t < ntasks; t++) {
+        tasks[t].begin = t * chunk < s.nfront ? t * chunk : s.nfront;
+        tasks[t].end = tasks[t].begin + chunk < s.nfront ? tasks[t].begin + chunk : s.nfront;
+      }
+    }
+
+    for (size_t t = 0; t < ntasks; t++) {
+      tasks[t].s = &s;
+      tasks[t].nfound = 0;
+      tasks[t].found_edges = 0;
+    }
+    run_tasks(bottom_up ? bottom_up_task : top_down_task, tasks, ntasks);
+
+    // gather the next frontier
+    s.nfront = 0;
+    front_edges = 0;
+    for (size_t t = 0; t < ntasks; t++) {
+      memcpy(s.front + s.nfront, tasks[t].found, tasks[t].nfound * sizeof(size_t));
+      s.nfront += tasks[t].nfound;
+      front_edges += tasks[t].found_edges;
+    }
+    unexplored_edges -= front_edges < unexplored_edges ? front_edges : unexplored_edges;
+    s.level += 1;
+  }
+
+  for (size_t t = 0; t < nthreads; t++) {
+    free(tasks[t].found);
+  }
+  free(tasks);
+  free(s.front);
+  free((void *) s.visited);
+  free((void *) s.front_bits);
+  free((void *) s.next_bits);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "graph.h"
+
+// Direction switching thresholds (Beamer et al.)
+// Go bottom-up when the frontier's edges exceed the unexplored edges / BFS_ALPHA
+#define BFS_ALPHA 14
+// Go back top-down when the frontier shrinks below nvertices / BFS_BETA
+#define BFS_BETA 24
+
+// Breadth-first search from source, for graphs whose edges all weigh 1.
+// Fills dist and prev like dijkstra(): dist[i] = d(source, i), INF if
+// unreachable, prev[i] = predecessor of i on a shortest path or -1.
+// Switches between top-down and bottom-up steps depending on the frontier
+// size; bottom-up steps need undirected graphs. Each level is expanded by
+// nthreads threads. Runs on adjacency lists and compact edges.
+void bfs(graph *g, size_t source, double dist[], int prev[], size_t nthreads);
@@ -0,0 +1,605 @@
+#include "ch.h"
+#include <string.h>
+
+static void heap_push(ch_heap *h, double key, size_t v) {
+  if (h->size == h->max) {
+    h->max = h->max ? 2 * h->max : 64;
+    h->a = realloc(h->a, h->max * sizeof(ch_heap_item));
+    assert(h->a);
+  }
+  size_t i = h->size++;
+  while (i > 0 && h->a[(i - 1) / 2].key > key) {
+    h->a[i] = h->a[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  h->a[i] = (ch_heap_item) {key, v};
+}
+
+static ch_heap_item heap_pop(ch_heap *h) {
+  ch_heap_item top = h->a[0];
+  ch_heap_item last = h->a[--h->size];
+  size_t i = 0;
+  for (;;) {
+    size_t c = 2 * i + 1;
+    if (c >= h->size) break;
+    if (c + 1 < h->size && h->a[c + 1].key < h->a[c].key) c++;
+    if (h->a[c].key >= last.key) break;
+    h->a[i] = h->a[c];
+    i = c;
+  }
+  if (h->size > 0) {
+    h->a[i] = last;
+  }
+  return top;
+}
+
+// Edge of the graph being contracted. Each edge is a pair of arcs, one
+// in the list of either end, that know each other's position.
+typedef struct ch_arc {
+  size_t to;
+  double weight;
+  // vertex a shortcut bypasses, CH_NONE for original edges
+  size_t middle;
+  // position of the opposite arc in the list of 'to'
+  size_t twin;
+} ch_arc;
+
+// Adjacency list that grows as shortcuts are added
+typedef struct ch_arcs {
+  ch_arc *e;
+  size_t n;
+  size_t max;
+} ch_arcs;
+
+// Upward edges of a vertex, recorded at contraction time
+typedef struct ch_adj {
+  ch_edge *e;
+  size_t n;
+  size_t max;
+} ch_adj;
+
+typedef struct ch_builder {
+  graph *g;
+  ch_arcs *adj;
+  bool *contracted;
+  // contracted neighbours of each vertex
+  size_t *deleted;
+  // shortcuts the last simulated contraction of each vertex needed
+  size_t *estimate;
+  // priority each vertex was last queued with
+  double *priority;
+  // witness search state, reset through 'touched'
+  double *wdist;
+  // edges on the path wdist was found along
+  size_t *hops;
+  // vertices a witness search is looking for, marked with 'stamp'
+  size_t *target;
+  size_t stamp;
+  // length of the path through the contracted vertex to each target,
+  // negative once a witness is found or the target is settled
+  double *bound;
+  // neighbours of the vertex being contracted, heaviest edge first
+  ch_heap_item *by_weight;
+  size_t *touched;
+  size_t ntouched;
+  ch_heap heap;
+  // position of each vertex in the list indexed last, valid where
+  // listed holds 'indexed'
+  size_t *position;
+  size_t *listed;
+  size_t indexed;
+  // upward edges recorded at contraction time
+  ch_adj *up;
+} ch_builder;
+
+// Makes room for element n of an array of *max elements of size bytes
+static void *reserve(void *e, size_t n, size_t *max, size_t size) {
+  if (n < *max) return e;
+  *max = *max ? 2 * *max : 4;
+  e = realloc(e, *max * size);
+  assert(e);
+  return e;
+}
+
+// Adds edge x-y, which must not be there yet
+static void link_edge(ch_builder *b, size_t x, size_t y, double w, size_t middle) {
+  ch_arcs *ax = &b->adj[x];
+  ch_arcs *ay = &b->adj[y];
+  ax->e = reserve(ax->e, ax->n, &ax->max, sizeof(ch_arc));
+  ay->e = reserve(ay->e, ay->n, &ay->max, sizeof(ch_arc));
+  ax->e[ax->n] = (ch_arc) {y, w, middle, ay->n};
+  ay->e[ay->n] = (ch_arc) {x, w, middle, ax->n};
+  ax->n++;
+  ay->n++;
+}
+
+// Lowers the edge of arc i of x's list to w, if w is lighter
+static void lower_edge(ch_builder *b, size_t x, size_t i, double w, size_t middle) {
+  ch_arc *e = &b->adj[x].e[i];
+  if (w >= e->weight) return;
+  ch_arc *t = &b->adj[e->to].e[e->twin];
+  e->weight = t->weight = w;
+  e->middle = t->middle = middle;
+}
+
+// Adds edge x-y, or lowers it if it is there. The list of x must be
+// the one indexed last.
+static void add_edge(ch_builder *b, size_t x, size_t y, double w, size_t middle) {
+  if (b->listed[y] == b->indexed) {
+    lower_edge(b, x, b->position[y], w, middle);
+    return;
+  }
+  link_edge(b, x, y, w, middle);
+  b->listed[y] = b->indexed;
+  b->position[y] = b->adj[x].n - 1;
+}
+
+// Records where each neighbour of x is in its list, so that add_edge()
+// finds an existing edge without a scan
+static void index_list(ch_builder *b, size_t x) {
+  const ch_arcs *a = &b->adj[x];
+  b->indexed++;
+  for (size_t i = 0; i < a->n; i++) {
+    b->listed[a->e[i].to] = b->indexed;
+    b->position[a->e[i].to] = i;
+  }
+}
+
+// Removes arc i of x's list, the last arc taking its place
+static void drop_arc(ch_builder *b, size_t x, size_t i) {
+  ch_arcs *a = &b->adj[x];
+  a->e[i] = a->e[--a->n];
+  if (i < a->n) {
+    b->adj[a->e[i].to].e[a->e[i].twin].twin = i;
+  }
+}
+
+// Whether target x of the current search still lacks a witness
+static bool pending(const ch_builder *b, size_t x) {
+  return b->target[x] == b->stamp && b->bound[x] >= 0;
+}
+
+// Bound of the farthest target still pending, or -1 once there is none.
+// Targets come in by_weight heaviest first, and next skips those done.
+static double search_limit(const ch_builder *b, const ch_heap_item *by_weight,
+    size_t count, size_t *next) {
+  while (*next < count && !pending(b, by_weight[*next].v)) {
+    (*next)++;
+  }
+  return *next < count ? b->bound[by_weight[*next].v] : -1;
+}
+
+// Local Dijkstra from u avoiding vertex v, settling at most max_settled
+// vertices and nothing more than max_hops edges away. The targets are the
+// vertices marked with the current stamp, taken from by_weight. A target
+// is done once it is settled or reached within its bound, and the search
+// goes no farther than the largest bound of those left.
+static void witness_search(ch_builder *b, size_t u, size_t v, const ch_heap_item *by_weight,
+    size_t count, size_t max_settled, size_t max_hops) {
+  for (size_t i = 0; i < b->ntouched; i++) {
+    b->wdist[b->touched[i]] = INF;
+  }
+  b->ntouched = 0;
+  b->heap.size = 0;
+
+  b->wdist[u] = 0;
+  b->hops[u] = 0;
+  b->touched[b->ntouched++] = u;
+  heap_push(&b->heap, 0, u);
+
+  size_t next = 0;
+  double limit = search_limit(b, by_weight, count, &next);
+  size_t settled = 0;
+  while (b->heap.size > 0 && settled < max_settled && limit >= 0) {
+    ch_heap_item it = heap_pop(&b->heap);
+    if (it.key > b->wdist[it.v]) continue; // stale
+    if (it.key > limit) break;
+    settled++;
+    if (pending(b, it.v)) {
+      b->bound[it.v] = -1;
+      limit = search_limit(b, by_weight, count, &next);
+    }
+    if (b->hops[it.v] >= max_hops) continue;
+
+    const ch_arcs *a = &b->adj[it.v];
+    for (size_t i = 0; i < a->n; i++) {
+      size_t x = a->e[i].to;
+      if (x == v) continue;
+      double alt = it.key + a->e[i].weight;
+      if (alt <= limit && alt < b->wdist[x]) {
+        if (b->wdist[x] >= INF) {
+          b->touched[b->ntouched++] = x;
+        }
+        b->wdist[x] = alt;
+        b->hops[x] = b->hops[it.v] + 1;
+        heap_push(&b->heap, alt, x);
+        // a path this short is a witness whatever the search finds later
+        if (pending(b, x) && alt <= b->bound[x]) {
+          b->bound[x] = -1;
+          limit = search_limit(b, by_weight, count, &next);
+        }
+      }
+    }
+  }
+}
+
+static int heavier_first(const void *x, const void *y) {
+  const ch_heap_item *a = x, *b = y;
+  return (a->key < b->key) - (a->key > b->key);
+}
+
+// Counts the shortcuts contracting v requires, adding them if apply is set.
+// Estimates use a cheaper witness search: a missed witness only costs an
+// extra shortcut, never a wrong distance.
+static size_t contract(ch_builder *b, size_t v, bool apply) {
+  const ch_arcs *a = &b->adj[v];
+  size_t shortcuts = 0;
+  size_t max_settled = apply ? CH_WITNESS_LIMIT : CH_ESTIMATE_LIMIT;
+  size_t max_hops = apply ? SIZE_MAX : CH_ESTIMATE_HOPS;
+
+  // shortcuts only touch the lists of the neighbours, so a stays put
+  for (size_t i = 0; i < a->n; i++) {
+    b->by_weight[i] = (ch_heap_item) {a->e[i].weight, a->e[i].to};
+  }
+  qsort(b->by_weight, a->n, sizeof(ch_heap_item), heavier_first);
+
+  for (size_t i = 0; i + 1 < a->n; i++) {
+    size_t u = a->e[i].to;
+    double wu = a->e[i].weight;
+    index_list(b, u);
+
+    // the neighbours paired with u are the targets, unless an edge from
+    // u is already as short as the path through v
+    size_t ntargets = 0;
+    b->stamp++;
+    for (size_t j = i + 1; j < a->n; j++) {
+      size_t w = a->e[j].to;
+      double via = wu + a->e[j].weight;
+      if (b->listed[w] == b->indexed && b->adj[u].e[b->position[w]].weight <= via) continue;
+      b->target[w] = b->stamp;
+      b->bound[w] = via;
+      ntargets++;
+    }
+    if (ntargets == 0) continue;
+    witness_search(b, u, v, b->by_weight, a->n, max_settled, max_hops);
+
+    // each pair once, from the neighbour listed first
+    for (size_t j = i + 1; j < a->n; j++) {
+      size_t w = a->e[j].to;
+      double via = wu + a->e[j].weight;
+      if (b->target[w] == b->stamp && b->wdist[w] > via) {
+        shortcuts++;
+        if (apply) {
+          add_edge(b, u, w, via, v);
+        }
+      }
+    }
+  }
+
+  return shortcuts;
+}
+
+// Edge difference, plus contracted neighbours to spread contraction
+// evenly, from the last estimate of the shortcuts contracting v needs
+static double priority(const ch_builder *b, size_t v) {
+  return (double) b->estimate[v] - (double) b->adj[v].n + (double) b->deleted[v];
+}
+
+// priority() after simulating the contraction of v again
+static double estimate_priority(ch_builder *b, size_t v) {
+  b->estimate[v] = contract(b, v, false);
+  return priority(b, v);
+}
+
+// Whether an entry of the contraction order was superseded
+static bool is_stale(const ch_builder *b, ch_heap_item it) {
+  return b->contracted[it.v] || it.key != b->priority[it.v];
+}
+
+bool ch_suitable(const graph *g, const char **reason) {
+  assert(g);
+  if (g->directed) {
+    if (reason) *reason = "the graph is directed";
+    return false;
+  }
+  if (g->compact || g->packed) {
+    if (reason) *reason = "the edges are not in adjacency lists";
+    return false;
+  }
+  // nedges counts both directions of every edge
+  if (g->nedges > CH_MAX_DEGREE * g->nvertices) {
+    if (reason) *reason = "the graph is too dense";
+    return false;
+  }
+  return true;
+}
+
+contraction_hierarchy *ch_build(contraction_hierarchy *ch, graph *g) {
+  assert(ch);
+  assert(g);
+  assert(!g->directed);
+
+  size_t n = g->nvertices;
+  ch_builder b;
+  b.g = g;
+  b.adj = calloc(n, sizeof(ch_arcs));
+  b.up = calloc(n, sizeof(ch_adj));
+  b.contracted = calloc(n, sizeof(bool));
+  b.deleted = calloc(n, sizeof(size_t));
+  b.estimate = calloc(n, sizeof(size_t));
+  b.priority = calloc(n, sizeof(double));
+  b.wdist = calloc(n, sizeof(double));
+  b.hops = calloc(n, sizeof(size_t));
+  b.touched = calloc(n, sizeof(size_t));
+  b.ntouched = 0;
+  b.target = calloc(n, sizeof(size_t));
+  b.bound = calloc(n, sizeof(double));
+  b.by_weight = calloc(n, sizeof(ch_heap_item));
+  b.stamp = 0;
+  b.heap = (ch_heap) {NULL, 0, 0};
+  b.position = calloc(n, sizeof(size_t));
+  b.listed = calloc(n, sizeof(size_t));
+  b.indexed = 0;
+  assert(b.adj && b.up && b.contracted && b.deleted && b.estimate && b.priority);
+  assert(b.wdist && b.hops && b.touched && b.target && b.bound);
+  assert(b.by_weight && b.position && b.listed);
+
+  // working copy without self-loops and parallel edges. Lists hold both
+  // directions of every edge, so it is linked from its lower end.
+  for (size_t v = 0; v < n; v++) {
+    b.wdist[v] = INF;
+    index_list(&b, v);
+    for (edgenode *p = g->edges[v]; p; p = p->next) {
+      if (p->y > v) {
+        add_edge(&b, v, p->y, p->weight, CH_NONE);
+      }
+    }
+  }
+
+  ch->nvertices = n;
+  ch->rank = calloc(n, sizeof(size_t));
+  ch->nshortcuts = 0;
+  assert(ch->rank);
+
+  // order by priority. Contracting a vertex changes the degree and
+  // contracted count of its neighbours, which are queued again with their
+  // last estimate; a vertex reaching the top is simulated again and put
+  // back if it no longer comes first. Superseded entries are skipped.
+  ch_heap order = {NULL, 0, 0};
+  for (size_t v = 0; v < n; v++) {
+    b.priority[v] = estimate_priority(&b, v);
+    heap_push(&order, b.priority[v], v);
+  }
+
+  size_t next_rank = 0;
+  while (order.size > 0) {
+    ch_heap_item it = heap_pop(&order);
+    if (is_stale(&b, it)) continue;
+    b.priority[it.v] = estimate_priority(&b, it.v);
+    while (order.size > 0 && is_stale(&b, order.a[0])) {
+      heap_pop(&order);
+    }
+    if (order.size > 0 && b.priority[it.v] > order.a[0].key) {
+      heap_push(&order, b.priority[it.v], it.v);
+      continue;
+    }
+
+    size_t v = it.v;
+    size_t added = contract(&b, v, true);
+    ch->nshortcuts += added;
+
+    // remaining neighbours all rank higher than v
+    ch_arcs *a = &b.adj[v];
+    ch_adj *up = &b.up[v];
+    up->e = calloc(a->n ? a->n : 1, sizeof(ch_edge));
+    assert(up->e);
+    for (size_t i = 0; i < a->n; i++) {
+      size_t x = a->e[i].to;
+      up->e[up->n++] = (ch_edge) {x, a->e[i].weight, a->e[i].middle};
+      drop_arc(&b, x, a->e[i].twin);
+      b.deleted[x]++;
+      b.priority[x] = priority(&b, x);
+      heap_push(&order, b.priority[x], x);
+    }
+    up->max = a->n;
+    a->n = 0;
+    b.contracted[v] = true;
+    ch->rank[v] = next_rank++;
+  }
+
+  // upward graph in CSR form
+  ch->offsets = calloc(n + 1, sizeof(size_t));
+  assert(ch->offsets);
+  for (size_t v = 0; v < n; v++) {
+    ch->offsets[v + 1] = ch->offsets[v] + b.up[v].n;
+  }
+  ch->up = calloc(ch->offsets[n] ? ch->offsets[n] : 1, sizeof(ch_edge));
+  assert(ch->up);
+  for (size_t v = 0; v < n; v++) {
+    memcpy(&ch->up[ch->offsets[v]], b.up[v].e, b.up[v].n * sizeof(ch_edge));
+  }
+
+  ch->dist_f = calloc(n, sizeof(double));
+  ch->dist_b = calloc(n, sizeof(double));
+  ch->parent_f = calloc(n, sizeof(size_t));
+  ch->parent_b = calloc(n, sizeof(size_t));
+  // both searches touch each vertex at most once
+  ch->touched = calloc(2 * n, sizeof(size_t));
+  ch->chain = calloc(n, sizeof(size_t));
+  ch->path = calloc(n, sizeof(size_t));
+  ch->fwd = (ch_heap) {NULL, 0, 0};
+  ch->bwd = (ch_heap) {NULL, 0, 0};
+  assert(ch->dist_f && ch->dist_b && ch->parent_f && ch->parent_b);
+  assert(ch->touched && ch->chain && ch->path);
+  for (size_t v = 0; v < n; v++) {
+    ch->dist_f[v] = INF;
+    ch->dist_b[v] = INF;
+  }
+  ch->settled = 0;
+
+  for (size_t v = 0; v < n; v++) {
+    free(b.adj[v].e);
+    free(b.up[v].e);
+  }
+  free(b.adj);
+  free(b.up);
+  free(b.contracted);
+  free(b.deleted);
+  free(b.estimate);
+  free(b.priority);
+  free(b.wdist);
+  free(b.hops);
+  free(b.position);
+  free(b.listed);
+  free(b.touched);
+  free(b.target);
+  free(b.bound);
+  free(b.by_weight);
+  free(b.heap.a);
+  free(order.a);
+
+  return ch;
+}
+
+void ch_destroy(contraction_hierarchy *ch) {
+  assert(ch);
+  free(ch->rank);
+  free(ch->offsets);
+  free(ch->up);
+  free(ch->dist_f);
+  free(ch->dist_b);
+  free(ch->parent_f);
+  free(ch->parent_b);
+  free(ch->touched);
+  free(ch->chain);
+  free(ch->path);
+  free(ch->fwd.a);
+  free(ch->bwd.a);
+  memset(ch, 0, sizeof(*ch));
+}
+
+// Upward edge between x and y, stored at the lower ranked one
+static const ch_edge *find_edge(contraction_hierarchy *ch, size_t x, size_t y) {
+  size_t lo = ch->rank[x] < ch->rank[y] ? x : y;
+  size_t hi = lo == x ? y : x;
+  for (size_t i = ch->offsets[lo]; i < ch->offsets[lo + 1]; i++) {
+    if (ch->up[i].to == hi) {
+      return &ch->up[i];
+    }
+  }
+  return NULL;
+}
+
+// Appends the original vertices of edge x-y after x, up to and including y,
+// to path
+static void unpack(contraction_hierarchy *ch, size_t x, size_t y, size_t path[], size_t *len) {
+  const ch_edge *e = find_edge(ch, x, y);
+  assert(e);
+  if (e->middle == CH_NONE) {
+    path[(*len)++] = y;
+    return;
+  }
+  unpack(ch, x, e->middle, path, len);
+  unpack(ch, e->middle, y, path, len);
+}
+
+// Settles the minimum of one search direction
+static void query_step(contraction_hierarchy *ch, ch_heap *h, double *dist, size_t *parent,
+    const double *other, size_t *touched, size_t *ntouched, double *best, size_t *meet) {
+  ch_heap_item it = heap_pop(h);
+  if (it.key > dist[it.v]) return; // stale
+  ch->settled++;
+
+  if (other[it.v] < INF && it.key + other[it.v] < *best) {
+    *best = it.key + other[it.v];
+    *meet = it.v;
+  }
+
+  for (size_t i = ch->offsets[it.v]; i < ch->offsets[it.v + 1]; i++) {
+    const ch_edge *e = &ch->up[i];
+    double alt = it.key + e->weight;
+    if (alt < dist[e->to]) {
+      if (dist[e->to] >= INF) {
+        touched[(*ntouched)++] = e->to;
+      }
+      dist[e->to] = alt;
+      parent[e->to] = it.v;
+      heap_push(h, alt, e->to);
+    }
+  }
+}
+
+double ch_query(contraction_hierarchy *ch, size_t s, size_t t, double dist[], int prev[]) {
+  assert(ch);
+  assert(s < ch->nvertices && t < ch->nvertices);
+  size_t n = ch->nvertices;
+
+  for (size_t i = 0; i < n; i++) {
+    dist[i] = INF;
+    prev[i] = -1;
+  }
+
+  size_t *touched = ch->touched;
+  size_t ntouched = 0;
+  ch_heap *fwd = &ch->fwd;
+  ch_heap *bwd = &ch->bwd;
+  fwd->size = 0;
+  bwd->size = 0;
+
+  ch->settled = 0;
+  ch->dist_f[s] = 0;
+  ch->parent_f[s] = s;
+  ch->dist_b[t] = 0;
+  ch->parent_b[t] = t;
+  touched[ntouched++] = s;
+  touched[ntouched++] = t;
+  heap_push(fwd, 0, s);
+  heap_push(bwd, 0, t);
+
+  double best = INF;
+  size_t meet = CH_NONE;
+  while ((fwd->size > 0 && fwd->a[0].key < best) || (bwd->size > 0 && bwd->a[0].key < best)) {
+    bool forward = bwd->size == 0 || bwd->a[0].key >= best ||
+      (fwd->size > 0 && fwd->a[0].key < best && fwd->a[0].key <= bwd->a[0].key);
+    if (forward) {
+      query_step(ch, fwd, ch->dist_f, ch->parent_f, ch->dist_b, touched, &ntouched, &best, &meet);
+    } else {
+      query_step(ch, bwd, ch->dist_b, ch->parent_b, ch->dist_f, touched, &ntouched, &best, &meet);
+    }
+  }
+
+  if (meet != CH_NONE) {
+    // upward chain s .. meet, then meet .. t, both unpacked
+    size_t *chain = ch->chain;
+    size_t *path = ch->path;
+
+    size_t nchain = 0;
+    for (size_t v = meet; v != s; v = ch->parent_f[v]) {
+      chain[nchain++] = v;
+    }
+    chain[nchain++] = s;
+
+    size_t len = 0;
+    path[len++] = s;
+    for (size_t i = nchain - 1; i > 0; i--) {
+      unpack(ch, chain[i], chain[i - 1], path, &len);
+    }
+    for (size_t v = meet; v != t; v = ch->parent_b[v]) {
+      unpack(ch, v, ch->parent_b[v], path, &len);
+    }
+
+    dist[s] = 0;
+    for (size_t i = 1; i < len; i++) {
+      dist[path[i]] = dist[path[i - 1]] + find_edge(ch, path[i - 1], path[i])->weight;
+      prev[path[i]] = (int) path[i - 1];
+    }
+  }
+
+  // reset the search state for the next query
+  for (size_t i = 0; i < ntouched; i++) {
+    ch->dist_f[touched[i]] = INF;
+    ch->dist_b[touched[i]] = INF;
+  }
+
+  return best;
+}
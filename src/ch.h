@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "graph.h"
+
+// Marks an edge of the original graph, as opposed to a shortcut
+#define CH_NONE SIZE_MAX
+// Vertices a witness search may settle before giving up
+#define CH_WITNESS_LIMIT 2000
+// Cheaper limit used when estimating a vertex's priority
+#define CH_ESTIMATE_LIMIT 50
+// Edges a witness path may have when estimating a vertex's priority
+#define CH_ESTIMATE_HOPS 2
+// Largest average degree ch_build() is used on. Denser graphs have
+// little hierarchy to find: the shortcuts pile up and preprocessing
+// takes minutes.
+#define CH_MAX_DEGREE 32
+
+// Binary min-heap with lazy deletion, used by witness searches and queries
+typedef struct ch_heap_item {
+  double key;
+  size_t v;
+} ch_heap_item;
+
+typedef struct ch_heap {
+  ch_heap_item *a;
+  size_t size;
+  size_t max;
+} ch_heap;
+
+// Edge of the upward graph: from a vertex to a neighbour of higher rank
+typedef struct ch_edge {
+  size_t to;
+  double weight;
+  // vertex a shortcut bypasses, CH_NONE for original edges
+  size_t middle;
+} ch_edge;
+
+// Contraction hierarchy of an undirected graph.
+// Vertices are contracted in rank order. Contracting v adds a shortcut
+// u-w for every pair of neighbours whose shortest path runs through v.
+// A shortest path then climbs ranks from both endpoints, so queries only
+// search the upward graph.
+typedef struct contraction_hierarchy {
+  size_t nvertices;
+  // position of each vertex in the contraction order
+  size_t *rank;
+  // upward edges of vertex v are up[offsets[v]..offsets[v + 1])
+  size_t *offsets;
+  ch_edge *up;
+  // shortcuts added by the contraction
+  size_t nshortcuts;
+  // search state reused by queries
+  double *dist_f;
+  double *dist_b;
+  size_t *parent_f;
+  size_t *parent_b;
+  ch_heap fwd;
+  ch_heap bwd;
+  // vertices whose distances a query has to reset
+  size_t *touched;
+  // upward chain and unpacked path of a query
+  size_t *chain;
+  size_t *path;
+  // vertices settled by the last query
+  size_t settled;
+} contraction_hierarchy;
+
+// Checks whether a hierarchy of g is worth building: g must be undirected,
+// keep its edges in adjacency lists and have an average degree of at most
+// CH_MAX_DEGREE. Returns false with the reason set otherwise.
+bool ch_suitable(const graph *g, const char **reason);
+
+// Contracts every vertex of g, ordering them by edge difference.
+// g must pass ch_suitable(), apart from its degree.
+contraction_hierarchy *ch_build(contraction_hierarchy *ch, graph *g);
+
+// Frees the hierarchy
+void ch_destroy(contraction_hierarchy *ch);
+
+// Bidirectional upward search from s to t. Returns d(s, t).
+// Shortcuts on the path are unpacked into dist and prev, filled like
+// dijkstra() along the shortest path and INF / -1 elsewhere.
+double ch_query(contraction_hierarchy *ch, size_t s, size_t t, double dist[], int prev[]);
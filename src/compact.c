@@ -0,0 +1,188 @@
+#include "compact.h"
+#include "packed.h"
+#include "stats.h"
+#include <math.h>
+
+bool compact_check(const graph *g, compact_weights *kind, const char **reason) {
+  assert(g);
+  assert(kind);
+  if (g->nvertices >= UINT32_MAX) {
+    if (reason) *reason = "too many vertices for 32-bit ids";
+    return false;
+  }
+  if (g->unit_weights) {
+    *kind = CW_UNIT;
+    return true;
+  }
+
+  bool integral = true;
+  bool exact = true;
+  double max = 0.0;
+  for (size_t v = 0; v < g->nvertices; v++) {
+    for (edgenode *p = g->edges[v]; p; p = p->next) {
+      double w = p->weight;
+      if (w < 0 || w != floor(w)) integral = false;
+      if ((double) (float) w != w) exact = false;
+      if (w > max) max = w;
+    }
+  }
+
+  if (integral && max <= UINT16_MAX) {
+    *kind = CW_U16;
+  } else if (integral && max <= UINT32_MAX) {
+    *kind = CW_U32;
+  } else if (exact) {
+    *kind = CW_FLOAT;
+  } else {
+    if (reason) *reason = "weights would lose precision as floats";
+    return false;
+  }
+  return true;
+}
+
+size_t compact_weight_size(compact_weights kind) {
+  switch (kind) {
+  case CW_U16: return sizeof(uint16_t);
+  case CW_U32: return sizeof(uint32_t);
+  case CW_FLOAT: return sizeof(float);
+  default: return 0;
+  }
+}
+
+bool compact_graph(graph *g, const char **reason) {
+  assert(g);
+  assert(!g->compact);
+  compact_weights kind;
+  if (!compact_check(g, &kind, reason)) return false;
+
+  size_t n = g->nvertices;
+  size_t total = 0;
+  for (size_t v = 0; v < n; v++) {
+    total += g->degree[v];
+  }
+
+  compact_edges *c = calloc(1, sizeof(compact_edges));
+  assert(c);
+  c->kind = kind;
+  c->offsets = calloc(n + 1, sizeof(size_t));
+  c->targets = calloc(total ? total : 1, sizeof(uint32_t));
+  c->weights = kind == CW_UNIT ? NULL : calloc(total ? total : 1, compact_weight_size(kind));
+  assert(c->offsets && c->targets && (kind == CW_UNIT || c->weights));
+
+  size_t e = 0;
+  for (size_t v = 0; v < n; v++) {
+    c->offsets[v] = e;
+    for (edgenode *p = g->edges[v]; p; p = p->next, e++) {
+      c->targets[e] = (uint32_t) p->y;
+      switch (kind) {
+      case CW_U16: ((uint16_t *) c->weights)[e] = (uint16_t) p->weight; break;
+      case CW_U32: ((uint32_t *) c->weights)[e] = (uint32_t) p->weight; break;
+      case CW_FLOAT: ((float *) c->weights)[e] = (float) p->weight; break;
+      default: break;
+      }
+    }
+  }
+  c->offsets[n] = e;
+  assert(e == total);
+
+  // the lists are gone, degree stays for callers that size buffers
+  arena_destroy(&g->pool);
+  free(g->edges);
+  g->edges = NULL;
+  g->compact = c;
+  return true;
+}
+
+void compact_destroy(compact_edges *c) {
+  assert(c);
+  free(c->offsets);
+  free(c->targets);
+  free(c->weights);
+  free(c);
+}
+
+size_t graph_edge_bytes(const graph *g) {
+  assert(g);
+  size_t n = g->nvertices;
+  if (g->packed) {
+    return packed_bytes(g->packed, n);
+  }
+  if (g->compact) {
+    const compact_edges *c = g->compact;
+    size_t total = c->offsets[n];
+    return (n + 1) * sizeof(size_t) + total * (sizeof(uint32_t) + compact_weight_size(c->kind));
+  }
+  size_t total = 0;
+  for (size_t v = 0; v < n; v++) {
+    total += g->degree[v];
+  }
+  return n * sizeof(edgenode *) + total * sizeof(edgenode);
+}
+
+void compact_dijkstra(graph *g, size_t source, const size_t members[], size_t count,
+    double dist[], int prev[], priority_queue *pq) {
+  const compact_edges *c = g->compact;
+  assert(c);
+  assert(pq->max > count);
+  pq_clear(pq);
+  dist[source] = 0;
+
+  for (size_t k = 0; k < count; k++) {
+    size_t i = members ? members[k] : k;
+    if (i != source) {
+      dist[i] = INF;
+    }
+    prev[i] = -1;
+    pq_insert(pq, (int) i, dist[i]);
+  }
+
+  while (!pq_empty(pq)) {
+    size_t u = (size_t) pq_extract_min(pq);
+    for (size_t e = c->offsets[u]; e < c->offsets[u + 1]; e++) {
+      STATS_COUNT(ST_RELAX);
+      size_t y = c->targets[e];
+      int i = pq_index_of(pq, (int) y);
+      if (i < 0) continue;
+
+      double alt = dist[u] + compact_weight(c, e);
+      if (alt < dist[y]) {
+        dist[y] = alt;
+        prev[y] = (int) u;
+        pq_decrease_priority(pq, (size_t) i, alt);
+      }
+    }
+  }
+}
+
+void compact_prim(graph *g, size_t source, const size_t members[], size_t count,
+    int parents[], double keys[], priority_queue *pq) {
+  const compact_edges *c = g->compact;
+  assert(c);
+  assert(pq->max >= count);
+  pq_clear(pq);
+
+  for (size_t k = 0; k < count; k++) {
+    size_t i = members ? members[k] : k;
+    keys[i] = INF;
+    parents[i] = -1;
+    pq_insert(pq, (int) i, INF);
+  }
+
+  pq_decrease_priority(pq, (size_t) pq_index_of(pq, (int) source), 0);
+  keys[source] = 0;
+
+  while (!pq_empty(pq)) {
+    int u = pq_extract_min(pq);
+    for (size_t e = c->offsets[u]; e < c->offsets[u + 1]; e++) {
+      STATS_COUNT(ST_RELAX);
+      size_t y = c->targets[e];
+      double w = compact_weight(c, e);
+      int i = pq_index_of(pq, (int) y);
+      if (i >= 0 && w < keys[y]) {
+        parents[y] = u;
+        keys[y] = w;
+        pq_decrease_priority(pq, (size_t) i, w);
+      }
+    }
+  }
+}
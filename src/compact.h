@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include "graph.h"
+
+// How compact_edges stores weights
+typedef enum compact_weights {
+  CW_UNIT,  // every edge weighs 1, nothing stored
+  CW_U16,   // integral weights up to UINT16_MAX
+  CW_U32,   // integral weights up to UINT32_MAX
+  CW_FLOAT  // weights a float holds exactly
+} compact_weights;
+
+// Edges of a graph in contiguous arrays with 32-bit targets.
+// The edges of v are targets[offsets[v]..offsets[v + 1]), in the order
+// of its adjacency list, so searches visit them in the same order.
+typedef struct compact_edges {
+  size_t *offsets;
+  uint32_t *targets;
+  compact_weights kind;
+  // uint16_t, uint32_t or float per edge, NULL for CW_UNIT
+  void *weights;
+} compact_edges;
+
+// Entry e of weights stored as kind
+static inline double compact_weight_at(compact_weights kind, const void *weights, size_t e) {
+  switch (kind) {
+  case CW_U16: return ((const uint16_t *) weights)[e];
+  case CW_U32: return ((const uint32_t *) weights)[e];
+  case CW_FLOAT: return ((const float *) weights)[e];
+  default: return 1.0;
+  }
+}
+
+// Weight of edge e
+static inline double compact_weight(const compact_edges *c, size_t e) {
+  return compact_weight_at(c->kind, c->weights, e);
+}
+
+// Checks whether g fits the compact layout without losing precision.
+// Sets kind to the smallest weight storage that holds every weight, or
+// returns false with the reason set if the ids or weights do not fit.
+bool compact_check(const graph *g, compact_weights *kind, const char **reason);
+
+// Bytes per weight stored as kind
+size_t compact_weight_size(compact_weights kind);
+
+// Moves the edges of g to compact storage and frees its adjacency lists.
+// Returns false and leaves g as it is if compact_check() refuses it.
+// Only searches, spanning trees and components run on compact graphs.
+bool compact_graph(graph *g, const char **reason);
+
+void compact_destroy(compact_edges *c);
+
+// Bytes used by the edges of g, in any layout
+size_t graph_edge_bytes(const graph *g);
+
+// dijkstra_subset() and prim_subset() on compact edges
+void compact_dijkstra(graph *g, size_t source, const size_t members[], size_t count,
+    double dist[], int prev[], priority_queue *pq);
+void compact_prim(graph *g, size_t source, const size_t members[], size_t count,
+    int parents[], double keys[], priority_queue *pq);
@@ -0,0 +1,280 @@
+#include "components.h"
+#include "compact.h"
+#include "packed.h"
+#include <pthread.h>
+
+union_find *uf_init(union_find *uf, size_t n) {
+  assert(uf);
+  uf->n = n;
+  uf->parent = calloc(n, sizeof(size_t));
+  uf->size = calloc(n, sizeof(size_t));
+  assert(uf->parent && uf->size);
+  for (size_t i = 0; i < n; i++) {
+    uf->parent[i] = i;
+    uf->size[i] = 1;
+  }
+  return uf;
+}
+
+void uf_destroy(union_find *uf) {
+  assert(uf);
+  free(uf->parent);
+  free(uf->size);
+  uf->parent = NULL;
+  uf->size = NULL;
+  uf->n = 0;
+}
+
+size_t uf_find(union_find *uf, size_t x) {
+  assert(x < uf->n);
+  while (uf->parent[x] != x) {
+    uf->parent[x] = uf->parent[uf->parent[x]];
+    x = uf->parent[x];
+  }
+  return x;
+}
+
+bool uf_union(union_find *uf, size_t x, size_t y) {
+  x = uf_find(uf, x);
+  y = uf_find(uf, y);
+  if (x == y) return false;
+  if (uf->size[x] < uf->size[y]) {
+    size_t t = x;
+    x = y;
+    y = t;
+  }
+  uf->parent[y] = x;
+  uf->size[x] += uf->size[y];
+  return true;
+}
+
+concurrent_union_find *cuf_init(concurrent_union_find *uf, size_t n) {
+  assert(uf);
+  uf->n = n;
+  uf->parent = calloc(n, sizeof(_Atomic size_t));
+  assert(uf->parent);
+  for (size_t i = 0; i < n; i++) {
+    atomic_init(&uf->parent[i], i);
+  }
+  return uf;
+}
+
+void cuf_destroy(concurrent_union_find *uf) {
+  assert(uf);
+  free(uf->parent);
+  uf->parent = NULL;
+  uf->n = 0;
+}
+
+size_t cuf_find(concurrent_union_find *uf, size_t x) {
+  assert(x < uf->n);
+  for (;;) {
+    size_t p = atomic_load(&uf->parent[x]);
+    if (p == x) return x;
+    size_t gp = atomic_load(&uf->parent[p]);
+    if (p != gp) {
+      // path splitting, losing the race only skips a shortcut
+      atomic_compare_exchange_weak(&uf->parent[x], &p, gp);
+    }
+    x = gp;
+  }
+}
+
+bool cuf_union(concurrent_union_find *uf, size_t x, size_t y) {
+  for (;;) {
+    x = cuf_find(uf, x);
+    y = cuf_find(uf, y);
+    if (x == y) return false;
+    // link the larger root under the smaller one, parents only decrease
+    if (x < y) {
+      size_t t = x;
+      x = y;
+      y = t;
+    }
+    size_t expected = x;
+    if (atomic_compare_exchange_strong(&uf->parent[x], &expected, y)) {
+      return true;
+    }
+    // x stopped being a root meanwhile, retry from its new root
+  }
+}
+
+// Edges of a range of vertices merged by one thread
+typedef struct cc_task {
+  graph *g;
+  concurrent_union_find *uf;
+  size_t first;
+  size_t last;
+} cc_task;
+
+static void *cc_worker(void *arg) {
+  cc_task *t = arg;
+  const compact_edges *c = t->g->compact;
+  const packed_edges *pk = t->g->packed;
+  uint32_t *targets = pk ? malloc(pk->width * sizeof(uint32_t)) : NULL;
+  for (size_t v = t->first; v < t->last; v++) {
+    if (pk) {
+      size_t d = packed_decode(pk, v, targets);
+      for (size_t k = 0; k < d; k++) {
+        cuf_union(t->uf, v, targets[k]);
+      }
+      continue;
+    }
+    if (c) {
+      for (size_t e = c->offsets[v]; e < c->offsets[v + 1]; e++) {
+        cuf_union(t->uf, v, c->targets[e]);
+      }
+      continue;
+    }
+    for (edgenode *p = t->g->edges[v]; p; p = p->next) {
+      cuf_union(t->uf, v, p->y);
+    }
+  }
+  free(targets);
+  return NULL;
+}
+
+components *find_components(graph *g, components *cc, size_t nthreads) {
+  assert(g);
+  assert(cc);
+  size_t n = g->nvertices;
+  if (nthreads == 0) nthreads = 1;
+
+  // representative of each vertex
+  size_t *root = calloc(n, sizeof(size_t));
+  assert(root);
+
+  if (nthreads == 1) {
+    union_find uf;
+    uf_init(&uf, n);
+    const compact_edges *c = g->compact;
+    const packed_edges *pk = g->packed;
+    uint32_t *targets = pk ? malloc(pk->width * sizeof(uint32_t)) : NULL;
+    for (size_t v = 0; v < n; v++) {
+      if (pk) {
+        size_t d = packed_decode(pk, v, targets);
+        for (size_t k = 0; k < d; k++) {
+          uf_union(&uf, v, targets[k]);
+        }
+        continue;
+      }
+      if (c) {
+        for (size_t e = c->offsets[v]; e < c->offsets[v + 1]; e++) {
+          uf_union(&uf, v, c->targets[e]);
+        }
+        continue;
+      }
+      for (edgenode *p = g->edges[v]; p; p = p->next) {
+        uf_union(&uf, v, p->y);
+      }
+    }
+    free(targets);
+    for (size_t v = 0; v < n; v++) {
+      root[v] = uf_find(&uf, v);
+    }
+    uf_destroy(&uf);
+  } else {
+    concurrent_union_find uf;
+    cuf_init(&uf, n);
+    cc_task *tasks = calloc(nthreads, sizeof(cc_task));
+    pthread_t *threads = calloc(nthreads, sizeof(pthread_t));
+    assert(tasks && threads);
+    for (size_t i = 0; i < nthreads; i++) {
+      tasks[i] = (cc_task) {g, &uf, n * i / nthreads, n * (i + 1) / nthreads};
+    }
+    for (size_t i = 1; i < nthreads; i++) {
+      int err = pthread_create(&threads[i], NULL, cc_worker, &tasks[i]);
+      assert(err == 0);
+      (void) err;
+    }
+    cc_worker(&tasks[0]);
+    for (size_t i = 1; i < nthreads; i++) {
+      pthread_join(threads[i], NULL);
+    }
+    for (size_t v = 0; v < n; v++) {
+      root[v] = cuf_find(&uf, v);
+    }
+    free(tasks);
+    free(threads);
+    cuf_destroy(&uf);
+  }
+
+  // number components by first original id, reusing root's slots
+  cc->nvertices = n;
+  cc->count = 0;
+  cc->id = calloc(n, sizeof(size_t));
+  size_t *number = calloc(n, sizeof(size_t));
+  assert(cc->id && number);
+  for (size_t i = 0; i < n; i++) {
+    size_t v = graph_vertex(g, i);
+    size_t r = root[v];
+    if (number[r] == 0) {
+      number[r] = ++cc->count;
+    }
+    cc->id[v] = number[r] - 1;
+  }
+
+  cc->offsets = calloc(cc->count + 1, sizeof(size_t));
+  cc->vertices = calloc(n, sizeof(size_t));
+  assert(cc->offsets && cc->vertices);
+  for (size_t v = 0; v < n; v++) {
+    cc->offsets[cc->id[v] + 1]++;
+  }
+  for (size_t c = 0; c < cc->count; c++) {
+    cc->offsets[c + 1] += cc->offsets[c];
+  }
+  // fill in original id order, using number as the insertion cursor
+  memcpy(number, cc->offsets, cc->count * sizeof(size_t));
+  for (size_t i = 0; i < n; i++) {
+    size_t v = graph_vertex(g, i);
+    cc->vertices[number[cc->id[v]]++] = v;
+  }
+
+  free(root);
+  free(number);
+  return cc;
+}
+
+void components_destroy(components *cc) {
+  assert(cc);
+  free(cc->id);
+  free(cc->offsets);
+  free(cc->vertices);
+  cc->id = NULL;
+  cc->offsets = NULL;
+  cc->vertices = NULL;
+  cc->count = 0;
+}
+
+void shortest_paths_within(graph *g, const components *cc, size_t source,
+    double dist[], int prev[], priority_queue *pq) {
+  assert(source < cc->nvertices);
+  size_t c = cc->id[source];
+  if (component_size(cc, c) < cc->nvertices) {
+    for (size_t v = 0; v < cc->nvertices; v++) {
+      dist[v] = INF;
+      prev[v] = -1;
+    }
+  }
+  dijkstra_subset(g, source, component_vertices(cc, c), component_size(cc, c), dist, prev, pq);
+}
+
+void spanning_forest(graph *g, const components *cc, int parents[], double keys[],
+    priority_queue *pq) {
+  // scanning keys beats the heap once most vertex pairs are edges
+  if (!g->directed && graph_density(g) >= PRIM_DENSITY) {
+    size_t *roots = calloc(cc->count, sizeof(size_t));
+    assert(roots);
+    for (size_t c = 0; c < cc->count; c++) {
+      roots[c] = component_vertices(cc, c)[0];
+    }
+    prim_dense(g, roots, cc->count, parents, keys);
+    free(roots);
+    return;
+  }
+
+  for (size_t c = 0; c < cc->count; c++) {
+    const size_t *members = component_vertices(cc, c);
+    prim_subset(g, members[0], members, component_size(cc, c), parents, keys, pq);
+  }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdatomic.h>
+#include "graph.h"
+
+// Disjoint sets with union by size and path halving
+typedef struct union_find {
+  size_t *parent;
+  size_t *size;
+  size_t n;
+} union_find;
+
+union_find *uf_init(union_find *uf, size_t n);
+void uf_destroy(union_find *uf);
+// Representative of x's set
+size_t uf_find(union_find *uf, size_t x);
+// Merges the sets of x and y, returns whether they were apart
+bool uf_union(union_find *uf, size_t x, size_t y);
+
+// Disjoint sets safe to update from several threads without locks.
+// Roots are linked under the smaller root with a CAS on the parent,
+// finds split paths with CAS too, so concurrent operations never undo
+// each other's links.
+typedef struct concurrent_union_find {
+  _Atomic size_t *parent;
+  size_t n;
+} concurrent_union_find;
+
+concurrent_union_find *cuf_init(concurrent_union_find *uf, size_t n);
+void cuf_destroy(concurrent_union_find *uf);
+size_t cuf_find(concurrent_union_find *uf, size_t x);
+bool cuf_union(concurrent_union_find *uf, size_t x, size_t y);
+
+// Connected components of a graph (weakly connected if directed).
+// Components are numbered by their smallest original vertex id and list
+// their vertices by original id.
+typedef struct components {
+  size_t count;
+  size_t nvertices;
+  // component of each vertex
+  size_t *id;
+  // vertices of component c are vertices[offsets[c]..offsets[c + 1])
+  size_t *offsets;
+  size_t *vertices;
+} components;
+
+// Finds the components of g. With more than one thread, the edges are
+// split among nthreads threads merging into a concurrent union-find.
+components *find_components(graph *g, components *cc, size_t nthreads);
+
+void components_destroy(components *cc);
+
+// Number of vertices in component c
+static inline size_t component_size(const components *cc, size_t c) {
+  return cc->offsets[c + 1] - cc->offsets[c];
+}
+
+// Vertices of component c
+static inline const size_t *component_vertices(const components *cc, size_t c) {
+  return &cc->vertices[cc->offsets[c]];
+}
+
+// dijkstra() from source, searching only its component.
+// dist and prev of other vertices are set to INF and -1.
+void shortest_paths_within(graph *g, const components *cc, size_t source,
+    double dist[], int prev[], priority_queue *pq);
+
+// prim() on every component, each tree growing from the component's
+// first vertex. Roots have parent -1. Undirected graphs with an edge
+// density of at least PRIM_DENSITY run prim_dense() instead.
+void spanning_forest(graph *g, const components *cc, int parents[], double keys[],
+    priority_queue *pq);
@@ -0,0 +1,200 @@
+#include "deque.h"
+#include <string.h>
+#include <assert.h>
+
+// slot of the ith element
+static inline size_t slotOf(Deque *dq, uint64_t i) {
+  return (dq->head + i) & (dq->capacity - 1);
+}
+
+static inline void *slotRef(Deque *dq, size_t slot) {
+  return dq->data + slot * dq->size;
+}
+
+// Copies n elements starting at the ith element into out, handling wrap around
+static void copyOut(Deque *dq, uint64_t i, void *out, size_t n) {
+  size_t s = slotOf(dq, i);
+  size_t first = dq->capacity - s < n ? dq->capacity - s : n;
+  memcpy(out, slotRef(dq, s), first * dq->size);
+  memcpy((unsigned char *) out + first * dq->size, dq->data, (n - first) * dq->size);
+}
+
+// Copies n elements from in to the slots starting at slot s
+static void copyIn(Deque *dq, size_t s, const void *in, size_t n) {
+  size_t first = dq->capacity - s < n ? dq->capacity - s : n;
+  memcpy(slotRef(dq, s), in, first * dq->size);
+  memcpy(dq->data, (const unsigned char *) in + first * dq->size, (n - first) * dq->size);
+}
+
+Deque *initDeque(deinitFunction deinit, size_t elementSize) {
+  assert(elementSize > 0);
+  Deque *dq = calloc(1, sizeof(Deque));
+  assert(dq != NULL);
+
+  dq->deinit = deinit;
+  dq->size = elementSize;
+  dq->count = 0;
+  dq->head = 0;
+  dq->capacity = DEQUE_MIN_CAPACITY;
+  dq->data = calloc(dq->capacity, elementSize);
+  assert(dq->data != NULL);
+
+  return dq;
+}
+
+void deinitDeque(Deque *dq) {
+  assert(dq != NULL);
+  dequeClear(dq);
+  free(dq->data);
+  free(dq);
+}
+
+void dequeReserve(Deque *dq, size_t capacity) {
+  assert(dq != NULL);
+  if (capacity <= dq->capacity) return;
+
+  size_t c = dq->capacity;
+  while (c < capacity) {
+    c *= 2;
+  }
+
+  // unwrap the elements at the start of the new buffer
+  unsigned char *data = calloc(c, dq->size);
+  assert(data != NULL);
+  copyOut(dq, 0, data, dq->count);
+  free(dq->data);
+
+  dq->data = data;
+  dq->capacity = c;
+  dq->head = 0;
+}
+
+void dequeClear(Deque *dq) {
+  assert(dq != NULL);
+  if (dq->deinit != NULL) {
+    for (uint64_t i = 0; i < dq->count; i++) {
+      dq->deinit(slotRef(dq, slotOf(dq, i)));
+    }
+  }
+  dq->count = 0;
+  dq->head = 0;
+}
+
+// Modifiers
+void dequePushBack(Deque *dq, const void *element) {
+  assert(dq != NULL);
+  assert(element != NULL);
+  if (dq->count == dq->capacity) {
+    dequeReserve(dq, dq->capacity * 2);
+  }
+  memcpy(slotRef(dq, slotOf(dq, dq->count)), element, dq->size);
+  dq->count += 1;
+}
+
+void dequePushFront(Deque *dq, const void *element) {
+  assert(dq != NULL);
+  assert(element != NULL);
+  if (dq->count == dq->capacity) {
+    dequeReserve(dq, dq->capacity * 2);
+  }
+  dq->head = (dq->head - 1) & (dq->capacity - 1);
+  memcpy(slotRef(dq, dq->head), element, dq->size);
+  dq->count += 1;
+}
+
+void dequePopFront(Deque *dq, void *data) {
+  assert(dq != NULL);
+  if (dq->count == 0) return;
+  void *p = slotRef(dq, dq->head);
+  if (data != NULL) {
+    memcpy(data, p, dq->size);
+  } else if (dq->deinit != NULL) {
+    dq->deinit(p);
+  }
+  dq->head = (dq->head + 1) & (dq->capacity - 1);
+  dq->count -= 1;
+}
+
+void dequePopBack(Deque *dq, void *data) {
+  assert(dq != NULL);
+  if (dq->count == 0) return;
+  void *p = slotRef(dq, slotOf(dq, dq->count - 1));
+  if (data != NULL) {
+    memcpy(data, p, dq->size);
+  } else if (dq->deinit != NULL) {
+    dq->deinit(p);
+  }
+  dq->count -= 1;
+}
+
+// Bulk modifiers
+void dequePushBackN(Deque *dq, const void *elements, size_t n) {
+  assert(dq != NULL);
+  assert(elements != NULL || n == 0);
+  dequeReserve(dq, dq->count + n);
+  copyIn(dq, slotOf(dq, dq->count), elements, n);
+  dq->count += n;
+}
+
+void dequePushFrontN(Deque *dq, const void *elements, size_t n) {
+  assert(dq != NULL);
+  assert(elements != NULL || n == 0);
+  dequeReserve(dq, dq->count + n);
+  dq->head = (dq->head - n) & (dq->capacity - 1);
+  copyIn(dq, dq->head, elements, n);
+  dq->count += n;
+}
+
+size_t dequePopFrontN(Deque *dq, void *data, size_t n) {
+  assert(dq != NULL);
+  assert(data != NULL);
+  if (n > dq->count) {
+    n = dq->count;
+  }
+  copyOut(dq, 0, data, n);
+  dq->head = slotOf(dq, n);
+  dq->count -= n;
+  return n;
+}
+
+size_t dequePopBackN(Deque *dq, void *data, size_t n) {
+  assert(dq != NULL);
+  assert(data != NULL);
+  if (n > dq->count) {
+    n = dq->count;
+  }
+  copyOut(dq, dq->count - n, data, n);
+  dq->count -= n;
+  return n;
+}
+
+// Accessors
+uint64_t dequeCount(Deque *dq) {
+  assert(dq != NULL);
+  return dq->count;
+}
+
+bool dequeIsEmpty(Deque *dq) {
+  assert(dq != NULL);
+  return dq->count == 0;
+}
+
+void *dequeAt(Deque *dq, uint64_t i) {
+  assert(dq != NULL);
+  if (i >= dq->count) {
+    return NULL;
+  }
+  return slotRef(dq, slotOf(dq, i));
+}
+
+void *dequeFront(Deque *dq) {
+  return dequeAt(dq, 0);
+}
+
+void *dequeBack(Deque *dq) {
+  assert(dq != NULL);
+  if (dq->count == 0) {
+    return NULL;
+  }
+  return dequeAt(dq, dq->count - 1);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "list.h" // deinitFunction
+
+// Initial capacity of a deque, in elements
+#define DEQUE_MIN_CAPACITY 16
+
+typedef struct Deque {
+  // Number of elements on the deque
+  uint64_t count;
+  // Size of a data element
+  size_t size;
+  // Deinit function for data element
+  deinitFunction deinit;
+  // Ring buffer holding capacity elements
+  unsigned char *data;
+  // Number of slots in data, always a power of two
+  size_t capacity;
+  // Slot of the first element
+  size_t head;
+} Deque;
+
+// Initializes deque
+// deinitFunction: Function to be called on elements dropped by the deque.
+// Elements live inline in the ring buffer, so it must not free the element itself.
+// elementSize: Size of the stored data element.
+Deque *initDeque(deinitFunction deinit, size_t elementSize);
+// Frees up the deque and all its elements
+void deinitDeque(Deque *dq);
+
+// Makes room for at least capacity elements
+void dequeReserve(Deque *dq, size_t capacity);
+// Removes all elements, keeping the buffer
+void dequeClear(Deque *dq);
+
+// Modifiers
+// Inserts element after the last element
+void dequePushBack(Deque *dq, const void *element);
+// Inserts element before the first element
+void dequePushFront(Deque *dq, const void *element);
+
+// Removes the first element.
+// Data is copied to the 'data' pointer, or deinitialized if it is NULL.
+void dequePopFront(Deque *dq, void *data);
+// Removes the last element.
+// Data is copied to the 'data' pointer, or deinitialized if it is NULL.
+void dequePopBack(Deque *dq, void *data);
+
+// Bulk modifiers
+// Appends n contiguous elements, in order
+void dequePushBackN(Deque *dq, const void *elements, size_t n);
+// Prepends n contiguous elements, elements[0] becomes the first element
+void dequePushFrontN(Deque *dq, const void *elements, size_t n);
+// Removes up to n elements from the front into 'data', in order.
+// Returns the number of removed elements.
+size_t dequePopFrontN(Deque *dq, void *data, size_t n);
+// Removes up to n elements from the back into 'data', in order.
+// Returns the number of removed elements.
+size_t dequePopBackN(Deque *dq, void *data, size_t n);
+
+// Accessors
+uint64_t dequeCount(Deque *dq);
+bool dequeIsEmpty(Deque *dq);
+// Reference to the ith element from the front, NULL if out of range
+void *dequeAt(Deque *dq, uint64_t i);
+void *dequeFront(Deque *dq);
+void *dequeBack(Deque *dq);
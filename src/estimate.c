@@ -0,0 +1,159 @@
+#include "estimate.h"
+#include <math.h>
+
+// splitmix64, small and good enough to draw sources
+static uint64_t next_random(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static int dbl_cmp(const void *x, const void *y) {
+  double a = *(const double *) x;
+  double b = *(const double *) y;
+  return (a > b) - (a < b);
+}
+
+// Adds the distances from one source to est. sorted holds the
+// n - 1 distances to the other vertices and is sorted in place.
+static void add_source(dd_estimate *est, double *sorted, size_t count) {
+  qsort(sorted, count, sizeof(double), dbl_cmp);
+  double pairs = (double) (est->population - 1);
+
+  size_t i = 0;
+  while (i < count && sorted[i] < INF) {
+    size_t j = i;
+    while (j < count && sorted[j] == sorted[i]) j++;
+    double p = (double) (j - i) / pairs;
+
+    dd_moments m = {0.0, 0.0};
+    bool found = ht_get_value(&est->table, &sorted[i], &m);
+    m.sum += p;
+    m.sumsq += p * p;
+    if (found) {
+      ht_set_value(&est->table, &sorted[i], &m);
+    } else {
+      ht_insert(&est->table, &sorted[i], &m);
+    }
+    i = j;
+  }
+
+  double p = (double) (count - i) / pairs;
+  est->unreachable.sum += p;
+  est->unreachable.sumsq += p * p;
+  est->samples++;
+}
+
+dd_estimate *estimate_distribution(graph *g, dd_estimate *est, const dd_sampling *sampling) {
+  assert(g);
+  assert(est);
+  assert(sampling);
+  size_t n = g->nvertices;
+  assert(n > 1);
+
+  ht_init(&est->table, sizeof(double), sizeof(dd_moments), HT_DEFAULT_SIZE);
+  est->table.kcomp = __dbl_kcomp;
+  est->unreachable = (dd_moments) {0.0, 0.0};
+  est->samples = 0;
+  est->population = n;
+
+  size_t budget = sampling->samples && sampling->samples < n ? sampling->samples : n;
+
+  // a shuffled prefix of the vertices is a sample without replacement
+  size_t *order = calloc(n, sizeof(size_t));
+  double *sorted = calloc(n, sizeof(double));
+  double *dists = calloc(n * SSSP_BATCH, sizeof(double));
+  int *prev = calloc(n, sizeof(int));
+  assert(order && sorted && dists && prev);
+  for (size_t i = 0; i < n; i++) {
+    order[i] = i;
+  }
+  uint64_t state = sampling->seed;
+  for (size_t i = 0; i < budget; i++) {
+    size_t j = i + (size_t) (next_random(&state) % (n - i));
+    size_t t = order[i];
+    order[i] = order[j];
+    order[j] = t;
+  }
+
+  priority_queue *pq = pq_init(calloc(1, sizeof(priority_queue)), n + 1);
+
+  // bfs() for unit weights and a single search for compact or packed
+  // edges, otherwise sources share a batched search
+  bool single = g->unit_weights || g->compact || g->packed;
+  size_t next = 0;
+  while (next < budget) {
+    size_t k = budget - next < SSSP_BATCH ? budget - next : SSSP_BATCH;
+    if (single) {
+      k = 1;
+      dijkstra_pq(g, order[next], dists, prev, pq);
+    } else {
+      sssp_batch(g, &order[next], k, dists);
+    }
+
+    for (size_t l = 0; l < k; l++) {
+      size_t s = order[next + l];
+      size_t count = 0;
+      for (size_t v = 0; v < n; v++) {
+        if (v == s) continue;
+        sorted[count++] = single ? dists[v] : dists[v * SSSP_BATCH + l];
+      }
+      add_source(est, sorted, count);
+    }
+    next += k;
+
+    if (sampling->error > 0 && est->samples >= ESTIMATE_MIN_SAMPLES &&
+        estimate_error(est) <= sampling->error) {
+      break;
+    }
+  }
+
+  free(order);
+  free(sorted);
+  free(dists);
+  free(prev);
+  pq_destroy(pq);
+  free(pq);
+  return est;
+}
+
+void estimate_destroy(dd_estimate *est) {
+  assert(est);
+  ht_destroy(&est->table);
+  est->samples = 0;
+}
+
+double estimate_fraction(const dd_estimate *est, const dd_moments *m, double *error) {
+  double k = (double) est->samples;
+  double mean = m->sum / k;
+  if (error) {
+    // sample variance of the per source fractions, corrected for
+    // drawing without replacement from a finite population
+    double var = k > 1 ? (m->sumsq - k * mean * mean) / (k - 1) : 0.0;
+    if (var < 0) var = 0;
+    double fpc = 1.0 - k / (double) est->population;
+    *error = ESTIMATE_Z * sqrt(var / k * fpc);
+  }
+  return mean;
+}
+
+double estimate_error(dd_estimate *est) {
+  double widest = 0.0;
+  estimate_fraction(est, &est->unreachable, &widest);
+
+  size_t count = est->table.count;
+  double *dists = calloc(count, sizeof(double));
+  dd_moments *moments = calloc(count, sizeof(dd_moments));
+  assert(dists && moments);
+  ht_arrays(&est->table, (uint8_t *) dists, (uint8_t *) moments);
+  for (size_t i = 0; i < count; i++) {
+    double error;
+    estimate_fraction(est, &moments[i], &error);
+    if (error > widest) widest = error;
+  }
+
+  free(dists);
+  free(moments);
+  return widest;
+}
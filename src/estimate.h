@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include "graph.h"
+
+// Confidence of the reported intervals, in percent, and its z score
+#define ESTIMATE_CONFIDENCE 95
+#define ESTIMATE_Z 1.96
+// Sources searched before the error target is first checked
+#define ESTIMATE_MIN_SAMPLES 32
+// Seed used when none is given
+#define ESTIMATE_DEFAULT_SEED 1
+
+// Sum and sum of squares of the fraction of a source's pairs
+// falling at one distance, over the sampled sources
+typedef struct dd_moments {
+  double sum;
+  double sumsq;
+} dd_moments;
+
+// How many sources estimate_distribution() may search
+typedef struct dd_sampling {
+  // most sources searched, 0 for every vertex
+  size_t samples;
+  // stop once every confidence interval is at most this wide on
+  // each side, 0 to search all samples
+  double error;
+  uint64_t seed;
+} dd_sampling;
+
+// Distance distribution estimated from the pairs of a random sample
+// of sources. A pair at distance d belongs to both its endpoints, so
+// the fraction of a source's pairs at d is an unbiased estimate of
+// the fraction of all pairs at d.
+typedef struct dd_estimate {
+  // distance -> dd_moments
+  hash_table table;
+  // pairs without a path
+  dd_moments unreachable;
+  // sources searched out of population
+  size_t samples;
+  size_t population;
+} dd_estimate;
+
+// Searches sources drawn without replacement in an order fixed by
+// the seed until the budget in sampling runs out or the error target
+// is met, and accumulates their distances in est.
+dd_estimate *estimate_distribution(graph *g, dd_estimate *est, const dd_sampling *sampling);
+
+void estimate_destroy(dd_estimate *est);
+
+// Mean fraction of pairs in m and the half width of its confidence
+// interval, which shrinks to 0 as the sample covers every vertex
+double estimate_fraction(const dd_estimate *est, const dd_moments *m, double *error);
+
+// Widest half width over every distance and the unreachable pairs
+double estimate_error(dd_estimate *est);
@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <unistd.h>
+#include "writer.h"
+
+// Synthetic graph generator. Writes the input format read by main,
+// a vertex count followed by one 'x y weight' line per edge, as edges
+// are drawn, so only per-vertex state is ever held in memory.
+
+// Default R-MAT quadrant probabilities, as in Graph500
+#define RMAT_A 0.57
+#define RMAT_B 0.19
+#define RMAT_C 0.19
+
+// splitmix64, small and good enough to draw graphs
+static uint64_t next_random(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Uniform in [0, 1)
+static double next_unit(uint64_t *state) {
+  return (double) (next_random(state) >> 11) * 0x1.0p-53;
+}
+
+// Distribution edge weights are drawn from
+typedef enum weight_kind {
+  W_UNIT,     // every edge weighs 1
+  W_INT,      // integers uniform in [lo, hi]
+  W_UNIFORM,  // reals uniform in [lo, hi)
+  W_EXP       // reals exponential with mean lo
+} weight_kind;
+
+typedef struct weights {
+  weight_kind kind;
+  double lo;
+  double hi;
+  // reals are written with as many decimals as scale has zeros
+  uint64_t scale;
+} weights;
+
+// Edges written so far
+static size_t edges_written = 0;
+
+// Weight of the next edge in the distribution
+static void put_weight(writer *w, const weights *wt, uint64_t *state) {
+  switch (wt->kind) {
+  case W_UNIT:
+    writer_char(w, '1');
+    return;
+  case W_INT: {
+    uint64_t span = (uint64_t) (wt->hi - wt->lo) + 1;
+    writer_uint(w, (uint64_t) wt->lo + next_random(state) % span);
+    return;
+  }
+  default: {
+    double x = wt->kind == W_UNIFORM
+        ? wt->lo + (wt->hi - wt->lo) * next_unit(state)
+        : -wt->lo * log1p(-next_unit(state));
+    uint64_t units = (uint64_t) llround(x * (double) wt->scale);
+    writer_uint(w, units / wt->scale);
+    writer_char(w, '.');
+    for (uint64_t digit = wt->scale / 10; digit > 0; digit /= 10) {
+      writer_char(w, (char) ('0' + units / digit % 10));
+    }
+    return;
+  }
+  }
+}
+
+// Writes edge (x, y), 0 indexed, with a weight drawn from wt
+static void put_edge(writer *w, uint64_t x, uint64_t y, const weights *wt, uint64_t *state) {
+  writer_uint(w, x + 1);
+  writer_char(w, ' ');
+  writer_uint(w, y + 1);
+  writer_char(w, ' ');
+  put_weight(w, wt, state);
+  writer_char(w, '\n');
+  edges_written++;
+}
+
+// Erdos-Renyi G(n, p) with p set for m expected edges. Pairs are walked
+// in order, skipping a geometric number of them between edges
+// (Batagelj and Brandes), so there are no duplicates or self-loops.
+static void gen_er(writer *w, uint64_t n, uint64_t m, const weights *wt, uint64_t *state) {
+  double pairs = (double) n * (double) (n - 1) / 2.0;
+  double p = (double) m / pairs;
+  if (p >= 1.0) p = 1.0;
+  if (p <= 0.0) return;
+  double lq = log1p(-p);
+
+  uint64_t v = 1;
+  int64_t u = -1;
+  while (v < n) {
+    double r = next_unit(state);
+    u += 1 + (p >= 1.0 ? 0 : (int64_t) floor(log1p(-r) / lq));
+    while (v < n && u >= (int64_t) v) {
+      u -= (int64_t) v;
+      v++;
+    }
+    if (v < n) {
+      put_edge(w, (uint64_t) u, v, wt, state);
+    }
+  }
+}
+
+// R-MAT with m edges over the smallest power of two holding n vertices.
+// Each edge descends the adjacency matrix picking quadrants with
+// probabilities a, b, c and 1 - a - b - c. Ids are scrambled by an odd
+// multiplier so high degree vertices are spread out; ids past n and
+// self-loops are drawn again. Parallel edges are kept, main --dedup
+// drops them.
+static void gen_rmat(writer *w, uint64_t n, uint64_t m, const double abc[3],
+    const weights *wt, uint64_t *state) {
+  unsigned scale = 0;
+  while ((1ULL << scale) < n) scale++;
+  uint64_t mask = (1ULL << scale) - 1;
+  uint64_t mult = next_random(state) | 1;
+  uint64_t add = next_random(state);
+  double ab = abc[0] + abc[1];
+  double abc_sum = ab + abc[2];
+
+  for (uint64_t e = 0; e < m; e++) {
+    uint64_t x, y;
+    do {
+      x = 0;
+      y = 0;
+      for (unsigned level = 0; level < scale; level++) {
+        double r = next_unit(state);
+        x <<= 1;
+        y <<= 1;
+        if (r < abc[0]) {
+          // top left
+        } else if (r < ab) {
+          y |= 1;
+        } else if (r < abc_sum) {
+          x |= 1;
+        } else {
+          x |= 1;
+          y |= 1;
+        }
+      }
+      x = (x * mult + add) & mask;
+      y = (y * mult + add) & mask;
+    } while (x >= n || y >= n || x == y);
+    put_edge(w, x, y, wt, state);
+  }
+}
+
+// 2-D grid of rows of ceil(sqrt(n)) vertices, each joined to its right
+// and lower neighbour. The edge count is implied.
+static void gen_grid(writer *w, uint64_t n, const weights *wt, uint64_t *state) {
+  uint64_t cols = (uint64_t) ceil(sqrt((double) n));
+  for (uint64_t v = 0; v < n; v++) {
+    if ((v + 1) % cols != 0 && v + 1 < n) {
+      put_edge(w, v, v + 1, wt, state);
+    }
+    if (v + cols < n) {
+      put_edge(w, v, v + cols, wt, state);
+    }
+  }
+}
+
+// Random geometric graph: n points uniform in the unit square, joined
+// when closer than the radius giving about m edges. Points are bucketed
+// in cells as wide as the radius, so each point is only compared with
+// its own and the following neighbour cells. Holds the points, not the
+// edges.
+static void gen_geometric(writer *w, uint64_t n, uint64_t m, const weights *wt, uint64_t *state) {
+  double radius = sqrt(2.0 * (double) m / (M_PI * (double) n * (double) (n - 1)));
+  if (radius > 1.0) radius = 1.0;
+  uint64_t side = (uint64_t) (1.0 / radius);
+  if (side < 1) side = 1;
+  if (side * side > 4 * n) side = (uint64_t) sqrt(4.0 * (double) n);
+  uint64_t cells = side * side;
+
+  double *px = malloc(n * sizeof(double));
+  double *py = malloc(n * sizeof(double));
+  uint64_t *cell = malloc(n * sizeof(uint64_t));
+  // points sorted by cell, start[c] .. start[c + 1] in cell c
+  uint64_t *start = calloc(cells + 1, sizeof(uint64_t));
+  uint64_t *sorted = malloc(n * sizeof(uint64_t));
+  if (!px || !py || !cell || !start || !sorted) {
+    printf("Not enough memory for %llu points. Exiting.\n", (unsigned long long) n);
+    exit(EXIT_FAILURE);
+  }
+
+  for (uint64_t v = 0; v < n; v++) {
+    px[v] = next_unit(state);
+    py[v] = next_unit(state);
+    uint64_t cx = (uint64_t) (px[v] * (double) side);
+    uint64_t cy = (uint64_t) (py[v] * (double) side);
+    if (cx >= side) cx = side - 1;
+    if (cy >= side) cy = side - 1;
+    cell[v] = cy * side + cx;
+    start[cell[v] + 1]++;
+  }
+  for (uint64_t c = 0; c < cells; c++) {
+    start[c + 1] += start[c];
+  }
+  for (uint64_t v = 0; v < n; v++) {
+    sorted[start[cell[v]]++] = v;
+  }
+  // the fill moved every start one cell on
+  memmove(start + 1, start, cells * sizeof(uint64_t));
+  start[0] = 0;
+
+  double r2 = radius * radius;
+  // own cell and the neighbours not yet visited
+  static const int dx[] = {0, 1, -1, 0, 1};
+  static const int dy[] = {0, 0, 1, 1, 1};
+  for (uint64_t c = 0; c < cells; c++) {
+    int64_t cx = (int64_t) (c % side);
+    int64_t cy = (int64_t) (c / side);
+    for (uint64_t i = start[c]; i < start[c + 1]; i++) {
+      uint64_t a = sorted[i];
+      for (int k = 0; k < 5; k++) {
+        int64_t nx = cx + dx[k];
+        int64_t ny = cy + dy[k];
+        if (nx < 0 || ny < 0 || nx >= (int64_t) side || ny >= (int64_t) side) continue;
+        uint64_t d = (uint64_t) ny * side + (uint64_t) nx;
+        // in its own cell, a only pairs with the points after it
+        for (uint64_t j = k == 0 ? i + 1 : start[d]; j < start[d + 1]; j++) {
+          uint64_t b = sorted[j];
+          double ex = px[a] - px[b];
+          double ey = py[a] - py[b];
+          if (ex * ex + ey * ey < r2) {
+            put_edge(w, a, b, wt, state);
+          }
+        }
+      }
+    }
+  }
+
+  free(px);
+  free(py);
+  free(cell);
+  free(start);
+  free(sorted);
+}
+
+// Picks the decimals of real weights: 3, or more until the spread of the
+// draws covers a hundred steps, so small weights do not round to zero.
+// Returns false if the largest weight would not fit in a double's
+// mantissa at that precision.
+static bool set_decimals(weights *wt) {
+  double spread = wt->kind == W_UNIFORM ? wt->hi - wt->lo : wt->lo;
+  // -log1p(-u) stays below 37 for u < 1 drawn by next_unit()
+  double largest = wt->kind == W_UNIFORM ? wt->hi : 37.0 * wt->lo;
+  wt->scale = 1000;
+  while (spread * (double) wt->scale < 100.0 && largest * (double) wt->scale < 0x1p53) {
+    wt->scale *= 10;
+  }
+  return spread * (double) wt->scale >= 100.0 && largest * (double) wt->scale < 0x1p53;
+}
+
+static bool parse_weights(const char *arg, weights *wt) {
+  if (strcmp(arg, "unit") == 0) {
+    wt->kind = W_UNIT;
+    return true;
+  }
+  double a = 0, b = 0;
+  if (sscanf(arg, "int:%lf:%lf", &a, &b) == 2 && a >= 0 && b >= a && a == floor(a) && b == floor(b)) {
+    *wt = (weights) {W_INT, a, b, 0};
+    return true;
+  }
+  if (sscanf(arg, "uniform:%lf:%lf", &a, &b) == 2 && a >= 0 && b > a) {
+    *wt = (weights) {W_UNIFORM, a, b, 0};
+    return set_decimals(wt);
+  }
+  if (sscanf(arg, "exp:%lf", &a) == 1 && a > 0) {
+    *wt = (weights) {W_EXP, a, 0, 0};
+    return set_decimals(wt);
+  }
+  return false;
+}
+
+static void usage(const char *program) {
+  printf("Usage: %s model vertices edges [options]\n"
+      "  models: er, rmat, grid (edges ignored), geometric\n"
+      "  --seed=s                 random seed (default 1)\n"
+      "  --weights=unit|int:lo:hi|uniform:lo:hi|exp:mean\n"
+      "                           weight distribution (default int:1:100)\n"
+      "  --rmat=a,b,c             R-MAT quadrant probabilities\n"
+      "  --output=file            write to file instead of stdout\n", program);
+}
+
+int main(int argc, const char *argv[]) {
+  uint64_t seed = 1;
+  weights wt = {W_INT, 1, 100, 0};
+  double abc[3] = {RMAT_A, RMAT_B, RMAT_C};
+  const char *output = NULL;
+
+  // flags anywhere, as in main
+  int n = 0;
+  for (int i = 0; i < argc; i++) {
+    const char *arg = argv[i];
+    if (strncmp(arg, "--", 2) != 0) {
+      argv[n++] = arg;
+    } else if (strncmp(arg, "--seed=", 7) == 0) {
+      seed = strtoull(arg + 7, NULL, 10);
+    } else if (strncmp(arg, "--weights=", 10) == 0) {
+      if (!parse_weights(arg + 10, &wt)) {
+        printf("Invalid weights '%s'. Exiting.\n", arg + 10);
+        exit(EXIT_FAILURE);
+      }
+    } else if (strncmp(arg, "--rmat=", 7) == 0) {
+      if (sscanf(arg + 7, "%lf,%lf,%lf", &abc[0], &abc[1], &abc[2]) != 3 ||
+          abc[0] < 0 || abc[1] < 0 || abc[2] < 0 || abc[0] + abc[1] + abc[2] > 1.0) {
+        printf("Invalid R-MAT probabilities '%s'. Exiting.\n", arg + 7);
+        exit(EXIT_FAILURE);
+      }
+    } else if (strncmp(arg, "--output=", 9) == 0) {
+      output = arg + 9;
+    } else {
+      printf("Invalid option '%s'. Exiting.\n", arg);
+      exit(EXIT_FAILURE);
+    }
+  }
+  argc = n;
+
+  if (argc < 3) {
+    usage(argv[0]);
+    exit(EXIT_FAILURE);
+  }
+  const char *model = argv[1];
+  long long vertices = atoll(argv[2]);
+  long long edges = argc > 3 ? atoll(argv[3]) : 0;
+  // ids are read back as int
+  if (vertices < 2 || vertices > INT32_MAX) {
+    printf("Invalid vertex count '%s'. Exiting.\n", argv[2]);
+    exit(EXIT_FAILURE);
+  }
+  if (strcmp(model, "grid") != 0 && edges <= 0) {
+    printf("Invalid edge count '%s'. Exiting.\n", argc > 3 ? argv[3] : "");
+    exit(EXIT_FAILURE);
+  }
+
+  writer w;
+  if (!output) {
+    writer_fd(&w, STDOUT_FILENO);
+  } else if (!writer_file(&w, output)) {
+    printf("Could not open file '%s' for writing. Exiting.\n", output);
+    exit(EXIT_FAILURE);
+  }
+
+  writer_uint(&w, (uint64_t) vertices);
+  writer_char(&w, '\n');
+
+  uint64_t state = seed;
+  uint64_t nv = (uint64_t) vertices;
+  uint64_t ne = (uint64_t) edges;
+  if (strcmp(model, "er") == 0) {
+    gen_er(&w, nv, ne, &wt, &state);
+  } else if (strcmp(model, "rmat") == 0) {
+    gen_rmat(&w, nv, ne, abc, &wt, &state);
+  } else if (strcmp(model, "grid") == 0) {
+    gen_grid(&w, nv, &wt, &state);
+  } else if (strcmp(model, "geometric") == 0) {
+    gen_geometric(&w, nv, ne, &wt, &state);
+  } else {
+    printf("Invalid model '%s'. Exiting.\n", model);
+    exit(EXIT_FAILURE);
+  }
+
+  if (!writer_close(&w)) {
+    printf("Error writing output. Exiting.\n");
+    exit(EXIT_FAILURE);
+  }
+  fprintf(stderr, "Wrote %llu vertices and %zu edges.\n", (unsigned long long) nv, edges_written);
+  return 0;
+}
@@ -1,4 +1,10 @@
 #include "graph.h"
+#include "bfs.h"
+#include "apsp.h"
+#include "components.h"
+#include "compact.h"
+#include "packed.h"
+#include "stats.h"
 
 graph *init_graph(graph *g, size_t nvertices, size_t nedges, bool directed) {
   assert(g);
@@ -6,6 +12,8 @@ graph *init_graph(graph *g, size_t nvertices, size_t nedges, bool directed) {
   g->nvertices = nvertices;
   g->nedges = nedges;
   g->directed = directed;
+  g->unit_weights = true;
+  g->nthreads = 1;
 
   g->edges = calloc(nvertices, sizeof(edgenode *));
   assert(g->edges);
@@ -13,33 +21,52 @@ graph *init_graph(graph *g, size_t nvertices, size_t nedges, bool directed) {
   g->degree = calloc(nvertices, sizeof(size_t));
   assert(g->degree);
 
+  arena_init(&g->pool, 0);
+
+  g->label = NULL;
+  g->index = NULL;
+  g->compact = NULL;
+  g->packed = NULL;
+
   return g;
 }
 
 void destroy_graph(graph *g) {
   assert(g);
-  assert(g->edges);
+  assert(g->edges || g->compact || g->packed);
   assert(g->degree);
 
-  for (size_t i = 0; i < g->nvertices; ++i) {
-    destroy_list(g->edges[i]);
+  // edgenodes are released all at once with the arena
+  if (g->compact) {
+    compact_destroy(g->compact);
+    g->compact = NULL;
+  } else if (g->packed) {
+    packed_destroy(g->packed);
+    g->packed = NULL;
+  } else {
+    arena_destroy(&g->pool);
   }
 
   free(g->edges);
   free(g->degree);
+  free(g->label);
+  free(g->index);
 
   g->nvertices = 0;
   g->nedges = 0;
   g->directed = 0;
   g->edges = 0;
   g->degree = 0;
+  g->label = 0;
+  g->index = 0;
 }
 
 void destroy_list(edgenode *v) {
-  if (!v) return;
-  edgenode *n = v->next;
-  free(v);
-  destroy_list(n);
+  while (v) {
+    edgenode *n = v->next;
+    free(v);
+    v = n;
+  }
 }
 
 void insert_edge(graph *g, size_t x, size_t y, double w, bool directed) {
@@ -47,13 +74,15 @@ void insert_edge(graph *g, size_t x, size_t y, double w, bool directed) {
   assert(x < g->nvertices);
   assert(y < g->nvertices);
 
-  edgenode *p = calloc(1, sizeof(edgenode));
-  assert(p);
+  edgenode *p = arena_alloc(&g->pool, sizeof(edgenode));
   p->y = y;
   p->weight = w;
   p->next = g->edges[x];
   g->edges[x] = p;
   g->degree[x]++;
+  if (w != 1.0) {
+    g->unit_weights = false;
+  }
 
   if (!directed) {
     insert_edge(g, y, x, w, true);
@@ -62,6 +91,70 @@ void insert_edge(graph *g, size_t x, size_t y, double w, bool directed) {
   }
 }
 
+void insert_edges(graph *g, const edge edges[], size_t n, bool directed) {
+  assert(g);
+  assert(edges || n == 0);
+  size_t nv = g->nvertices;
+
+  // segment of the new edgenodes of each vertex
+  size_t *offsets = calloc(nv + 1, sizeof(size_t));
+  assert(offsets);
+  for (size_t i = 0; i < n; i++) {
+    assert(edges[i].x < nv);
+    assert(edges[i].y < nv);
+    offsets[edges[i].x + 1]++;
+    if (!directed) {
+      offsets[edges[i].y + 1]++;
+    }
+  }
+  for (size_t v = 0; v < nv; v++) {
+    offsets[v + 1] += offsets[v];
+  }
+  size_t total = offsets[nv];
+  if (total == 0) {
+    free(offsets);
+    return;
+  }
+
+  // insert_edge() pushes to the front, so the kth edge of v in the
+  // batch goes k slots before the end of its segment
+  edgenode *nodes = arena_alloc(&g->pool, total * sizeof(edgenode));
+  size_t *filled = calloc(nv, sizeof(size_t));
+  assert(filled);
+  for (size_t i = 0; i < n; i++) {
+    const edge *e = &edges[i];
+    size_t v = e->x;
+    edgenode *p = &nodes[offsets[v + 1] - 1 - filled[v]++];
+    p->y = e->y;
+    p->weight = e->weight;
+    if (!directed) {
+      v = e->y;
+      p = &nodes[offsets[v + 1] - 1 - filled[v]++];
+      p->y = e->x;
+      p->weight = e->weight;
+    }
+    if (e->weight != 1.0) {
+      g->unit_weights = false;
+    }
+  }
+
+  // link each segment in front of the edges already there
+  for (size_t v = 0; v < nv; v++) {
+    size_t first = offsets[v], last = offsets[v + 1];
+    if (first == last) continue;
+    for (size_t i = first; i + 1 < last; i++) {
+      nodes[i].next = &nodes[i + 1];
+    }
+    nodes[last - 1].next = g->edges[v];
+    g->edges[v] = &nodes[first];
+    g->degree[v] += last - first;
+  }
+  g->nedges += n;
+
+  free(offsets);
+  free(filled);
+}
+
 void print_graph(graph *g) {
   assert(g);
   for (size_t i = 0; i < g->nvertices; i++) {
@@ -75,12 +168,175 @@ void print_graph(graph *g) {
   }
 }
 
+// FNV-1a over the bytes at p
+static uint64_t fnv1a(uint64_t h, const void *p, size_t n) {
+  const unsigned char *b = p;
+  for (size_t i = 0; i < n; i++) {
+    h ^= b[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+double graph_density(const graph *g) {
+  assert(g);
+  // nedges already holds both directions of undirected edges
+  double pairs = (double) g->nvertices * (double) (g->nvertices - 1);
+  return pairs > 0 ? (double) g->nedges / pairs : 0.0;
+}
+
+uint64_t graph_fingerprint(graph *g) {
+  assert(g);
+  uint64_t h = 14695981039346656037ULL;
+  uint64_t n = g->nvertices;
+  h = fnv1a(h, &n, sizeof(n));
+  h = fnv1a(h, &g->directed, sizeof(g->directed));
+  const compact_edges *c = g->compact;
+  const packed_edges *pk = g->packed;
+  uint32_t *targets = pk ? malloc(pk->width * sizeof(uint32_t)) : NULL;
+  for (size_t i = 0; i < g->nvertices; i++) {
+    if (pk) {
+      // the sorted order the edges are packed in
+      size_t d = packed_decode(pk, i, targets);
+      for (size_t k = 0; k < d; k++) {
+        uint64_t y = targets[k];
+        double w = packed_weight(pk, pk->offsets[i] + k);
+        h = fnv1a(h, &y, sizeof(y));
+        h = fnv1a(h, &w, sizeof(w));
+      }
+      continue;
+    }
+    if (c) {
+      // same stream as the lists the edges came from
+      for (size_t e = c->offsets[i]; e < c->offsets[i + 1]; e++) {
+        uint64_t y = c->targets[e];
+        double w = compact_weight(c, e);
+        h = fnv1a(h, &y, sizeof(y));
+        h = fnv1a(h, &w, sizeof(w));
+      }
+      continue;
+    }
+    for (edgenode *p = g->edges[i]; p; p = p->next) {
+      uint64_t y = p->y;
+      h = fnv1a(h, &y, sizeof(y));
+      h = fnv1a(h, &p->weight, sizeof(p->weight));
+    }
+  }
+  free(targets);
+  return h;
+}
+
+void canonicalize_graph(graph *g, canon_stats *removed) {
+  assert(g);
+  size_t n = g->nvertices;
+
+  // per neighbour y of the vertex v being scanned, valid while
+  // seen[y] == v + 1: the lowest weight of an edge to y
+  size_t *seen = calloc(n, sizeof(size_t));
+  double *lightest = calloc(n, sizeof(double));
+  // done[y] == v + 1 once the edge to y is kept
+  size_t *done = calloc(n, sizeof(size_t));
+  assert(seen && lightest && done);
+
+  size_t total = 0, loops = 0, parallel = 0;
+  for (size_t v = 0; v < n; v++) {
+    for (edgenode *p = g->edges[v]; p; p = p->next) {
+      if (p->y == v) {
+        loops++;
+      } else if (seen[p->y] == v + 1) {
+        parallel++;
+      } else {
+        seen[p->y] = v + 1;
+        total++;
+      }
+    }
+  }
+
+  // the first of the lightest edges to each neighbour keeps its place
+  arena pool;
+  arena_init(&pool, 0);
+  edgenode *nodes = arena_alloc(&pool, (total ? total : 1) * sizeof(edgenode));
+  edgenode *next = nodes;
+  memset(seen, 0, n * sizeof(size_t));
+  g->unit_weights = true;
+  for (size_t v = 0; v < n; v++) {
+    for (edgenode *p = g->edges[v]; p; p = p->next) {
+      if (seen[p->y] != v + 1 || p->weight < lightest[p->y]) {
+        seen[p->y] = v + 1;
+        lightest[p->y] = p->weight;
+      }
+    }
+
+    edgenode *first = next;
+    for (edgenode *p = g->edges[v]; p; p = p->next) {
+      if (p->y == v || done[p->y] == v + 1 || p->weight != lightest[p->y]) continue;
+      done[p->y] = v + 1;
+      *next = (edgenode) {next + 1, p->y, p->weight};
+      if (p->weight != 1.0) {
+        g->unit_weights = false;
+      }
+      next++;
+    }
+
+    g->degree[v] = (size_t) (next - first);
+    g->edges[v] = next > first ? first : NULL;
+    if (next > first) {
+      next[-1].next = NULL;
+    }
+  }
+
+  arena_destroy(&g->pool);
+  g->pool = pool;
+  g->nedges = total;
+
+  if (removed) {
+    // undirected edges were seen from both ends, self-loops twice at one
+    removed->parallel = g->directed ? parallel : parallel / 2;
+    removed->loops = g->directed ? loops : loops / 2;
+  }
+
+  free(seen);
+  free(lightest);
+  free(done);
+}
+
 void dijkstra(graph *g, size_t source, double dist[], int prev[]) {
+  if (g->unit_weights && !g->packed) {
+    bfs(g, source, dist, prev, g->nthreads);
+    return;
+  }
+
   priority_queue *pq = pq_init(calloc(1, sizeof(priority_queue)), g->nvertices + 1);
+  dijkstra_pq(g, source, dist, prev, pq);
+  pq_destroy(pq);
+  free(pq);
+}
+
+void dijkstra_pq(graph *g, size_t source, double dist[], int prev[], priority_queue *pq) {
+  dijkstra_subset(g, source, NULL, g->nvertices, dist, prev, pq);
+}
+
+void dijkstra_subset(graph *g, size_t source, const size_t members[], size_t count,
+    double dist[], int prev[], priority_queue *pq) {
+  if (g->packed) {
+    packed_dijkstra(g, source, members, count, dist, prev, pq);
+    return;
+  }
+  if (g->unit_weights) {
+    bfs(g, source, dist, prev, g->nthreads);
+    return;
+  }
+  if (g->compact) {
+    compact_dijkstra(g, source, members, count, dist, prev, pq);
+    return;
+  }
 
+  assert(pq->max > count);
+  pq_clear(pq);
   dist[source] = 0;
 
-  for (size_t i = 0; i < g->nvertices; i++) {
+  for (size_t k = 0; k < count; k++) {
+    size_t i = members ? members[k] : k;
     if (i != source) {
       dist[i] = INF;
     }
@@ -92,6 +348,7 @@ void dijkstra(graph *g, size_t source, double dist[], int prev[]) {
     size_t u = (size_t) pq_extract_min(pq);
     edgenode *p = g->edges[u];
     while (p) {
+      STATS_COUNT(ST_RELAX);
       int i = pq_index_of(pq, (int) p->y);
       if (i < 0) {
         p = p->next;
@@ -108,16 +365,35 @@ void dijkstra(graph *g, size_t source, double dist[], int prev[]) {
       p = p->next;
     }
   }
+}
 
+void prim(graph *g, int parents[], double keys[]) {
+  priority_queue *pq = pq_init(calloc(1, sizeof(priority_queue)), MAX);
+  prim_pq(g, parents, keys, pq);
   pq_destroy(pq);
   free(pq);
 }
 
-void prim(graph *g, int parents[], double keys[]) {
-  size_t source = 0;
-  priority_queue *pq = pq_init(calloc(1, sizeof(priority_queue)), MAX);
+void prim_pq(graph *g, int parents[], double keys[], priority_queue *pq) {
+  // the tree grows from the first vertex of the input
+  prim_subset(g, graph_vertex(g, 0), NULL, g->nvertices, parents, keys, pq);
+}
 
-  for (size_t i = 0; i < g->nvertices; i++) {
+void prim_subset(graph *g, size_t source, const size_t members[], size_t count,
+    int parents[], double keys[], priority_queue *pq) {
+  if (g->compact) {
+    compact_prim(g, source, members, count, parents, keys, pq);
+    return;
+  }
+  if (g->packed) {
+    packed_prim(g, source, members, count, parents, keys, pq);
+    return;
+  }
+  assert(pq->max >= count);
+  pq_clear(pq);
+
+  for (size_t k = 0; k < count; k++) {
+    size_t i = members ? members[k] : k;
     keys[i] = INF;
     parents[i] = -1;
     pq_insert(pq, (int) i, INF);
@@ -132,6 +408,7 @@ void prim(graph *g, int parents[], double keys[]) {
     int u = pq_extract_min(pq);
     edgenode *p = g->edges[u];
     while (p) {
+      STATS_COUNT(ST_RELAX);
       int i = pq_index_of(pq, (int) p->y);
       if (i >= 0 && p->weight < keys[p->y]) {
         parents[p->y] = u;
@@ -141,12 +418,220 @@ void prim(graph *g, int parents[], double keys[]) {
       p = p->next;
     }
   }
+}
 
-  pq_destroy(pq);
-  free(pq);
+// Index of the smallest of a[0..n), the first one on ties. Independent
+// lanes keep a running minimum, which compiles to packed min
+// instructions, then a second pass finds where it is.
+static size_t min_index(const double *restrict a, size_t n) {
+  assert(n > 0);
+  double lanes[PRIM_LANES];
+  for (size_t l = 0; l < PRIM_LANES; l++) {
+    lanes[l] = HUGE_VAL;
+  }
+
+  size_t i = 0;
+  for (; i + PRIM_LANES <= n; i += PRIM_LANES) {
+    for (size_t l = 0; l < PRIM_LANES; l++) {
+      lanes[l] = a[i + l] < lanes[l] ? a[i + l] : lanes[l];
+    }
+  }
+
+  double min = HUGE_VAL;
+  for (size_t l = 0; l < PRIM_LANES; l++) {
+    if (lanes[l] < min) min = lanes[l];
+  }
+  for (; i < n; i++) {
+    if (a[i] < min) min = a[i];
+  }
+
+  for (i = 0; a[i] != min; i++);
+  return i;
+}
+
+void prim_dense(graph *g, const size_t roots[], size_t nroots, int parents[], double keys[]) {
+  assert(g);
+  assert(!g->directed);
+  size_t n = g->nvertices;
+  if (n == 0) return;
+
+  // key of each vertex still out of the tree, HUGE_VAL once it is in
+  double *frontier = malloc(n * sizeof(double));
+  assert(frontier);
+  for (size_t v = 0; v < n; v++) {
+    frontier[v] = INF;
+    keys[v] = INF;
+    parents[v] = -1;
+  }
+
+  const compact_edges *c = g->compact;
+  const packed_edges *pk = g->packed;
+  uint32_t *targets = pk ? malloc(pk->width * sizeof(uint32_t)) : NULL;
+  size_t next = 0;
+  for (size_t step = 0; step < n; step++) {
+    size_t u = min_index(frontier, n);
+    if (frontier[u] >= INF) {
+      // nothing left to reach from the current tree
+      assert(next < nroots);
+      u = roots[next++];
+      keys[u] = 0;
+    }
+    frontier[u] = HUGE_VAL;
+
+    if (pk) {
+      size_t first = pk->offsets[u];
+      size_t d = packed_decode(pk, u, targets);
+      for (size_t k = 0; k < d; k++) {
+        STATS_COUNT(ST_RELAX);
+        size_t y = targets[k];
+        double w = packed_weight(pk, first + k);
+        if (frontier[y] < HUGE_VAL && w < frontier[y]) {
+          frontier[y] = w;
+          keys[y] = w;
+          parents[y] = (int) u;
+        }
+      }
+      continue;
+    }
+    if (c) {
+      for (size_t e = c->offsets[u]; e < c->offsets[u + 1]; e++) {
+        STATS_COUNT(ST_RELAX);
+        size_t y = c->targets[e];
+        double w = compact_weight(c, e);
+        if (frontier[y] < HUGE_VAL && w < frontier[y]) {
+          frontier[y] = w;
+          keys[y] = w;
+          parents[y] = (int) u;
+        }
+      }
+      continue;
+    }
+    for (edgenode *p = g->edges[u]; p; p = p->next) {
+      STATS_COUNT(ST_RELAX);
+      if (frontier[p->y] < HUGE_VAL && p->weight < frontier[p->y]) {
+        frontier[p->y] = p->weight;
+        keys[p->y] = p->weight;
+        parents[p->y] = (int) u;
+      }
+    }
+  }
+
+  free(frontier);
+  free(targets);
+}
+
+#if defined(__GNUC__)
+// SSSP_BATCH doubles in one vector, only aligned like a double
+typedef double sssp_lanes __attribute__((vector_size(SSSP_BATCH * sizeof(double)), aligned(sizeof(double))));
+typedef long long sssp_mask __attribute__((vector_size(SSSP_BATCH * sizeof(double)), aligned(sizeof(double))));
+
+// dv = min(dv, du + w) over all lanes, returns whether any lane improved
+static inline bool sssp_relax_lanes(const double *du, double *dv, double w) {
+  sssp_lanes old = *(const sssp_lanes *) dv;
+  sssp_lanes alt = *(const sssp_lanes *) du + w;
+  sssp_mask less = alt < old;
+
+  sssp_mask any = less;
+  long long improved = 0;
+  for (size_t l = 0; l < SSSP_BATCH; l++) {
+    improved |= any[l];
+  }
+  if (!improved) return false;
+
+  *(sssp_lanes *) dv = (sssp_lanes) (((sssp_mask) alt & less) | ((sssp_mask) old & ~less));
+  return true;
+}
+#else
+static inline bool sssp_relax_lanes(const double *du, double *dv, double w) {
+  bool improved = false;
+  for (size_t l = 0; l < SSSP_BATCH; l++) {
+    double alt = du[l] + w;
+    if (alt < dv[l]) {
+      dv[l] = alt;
+      improved = true;
+    }
+  }
+  return improved;
+}
+#endif
+
+void sssp_batch(graph *g, const size_t sources[], size_t k, double dist[]) {
+  assert(g);
+  assert(k <= SSSP_BATCH);
+
+  for (size_t i = 0; i < g->nvertices * SSSP_BATCH; i++) {
+    dist[i] = INF;
+  }
+
+  // FIFO of vertices whose distances improved since they were last scanned
+  Deque *queue = initDeque(NULL, sizeof(size_t));
+  bool *queued = calloc(g->nvertices, sizeof(bool));
+  assert(queued);
+
+  for (size_t l = 0; l < k; l++) {
+    assert(sources[l] < g->nvertices);
+    dist[sources[l] * SSSP_BATCH + l] = 0;
+    if (!queued[sources[l]]) {
+      queued[sources[l]] = true;
+      dequePushBack(queue, &sources[l]);
+    }
+  }
+
+  while (!dequeIsEmpty(queue)) {
+    size_t u;
+    dequePopFront(queue, &u);
+    queued[u] = false;
+
+    const double *du = &dist[u * SSSP_BATCH];
+    for (edgenode *p = g->edges[u]; p; p = p->next) {
+      STATS_COUNT(ST_RELAX);
+      double *dv = &dist[p->y * SSSP_BATCH];
+      double w = p->weight;
+
+      // relax all lanes at once
+      bool improved = sssp_relax_lanes(du, dv, w);
+
+      if (improved && !queued[p->y]) {
+        queued[p->y] = true;
+        dequePushBack(queue, &p->y);
+      }
+    }
+  }
+
+  free(queued);
+  deinitDeque(queue);
+}
+
+// Adds one to the count of distance d, unreachable pairs are not counted
+static void dd_count(hash_table *ht, double d) {
+  if (d >= INF) return;
+  size_t tmp = 0;
+  if (ht_get_value(ht, &d, &tmp)) {
+    // add one to existing entry
+    size_t new = tmp + 1;
+    ht_set_value(ht, &d, &new);
+  } else {
+    // add new entry
+    tmp = 1;
+    ht_insert(ht, &d, &tmp);
+  }
+}
+
+// Whether every weight is a whole number, so that path lengths are exact
+// whatever order their weights are added in. floyd_warshall() adds them
+// in another order than the searches, and with fractional weights the
+// same distance may round differently and fall in another table entry.
+static bool integral_weights(const graph *g) {
+  compact_weights kind;
+  if (!compact_check(g, &kind, NULL)) return false;
+  return kind == CW_U16 || kind == CW_U32;
 }
 
 void distance_distribution(graph *g, hash_table *ht) {
+  distance_distribution_engine(g, ht, DD_AUTO);
+}
+
+void distance_distribution_engine(graph *g, hash_table *ht, dd_engine engine) {
   assert(g);
   assert(ht);
 
@@ -154,28 +639,106 @@ void distance_distribution(graph *g, hash_table *ht) {
   ht_init(ht, sizeof(double), sizeof(size_t), g->nedges * 2);
   ht->kcomp = __dbl_kcomp;
 
+  // compact and packed edges are only searched one source at a time
+  if (g->compact || g->packed) {
+    engine = DD_DIJKSTRA;
+  }
+
+  if (engine == DD_AUTO) {
+    // bfs() beats any weighted search on unit weights,
+    // dense graphs go through the all-pairs matrix
+    if (g->unit_weights) {
+      engine = DD_DIJKSTRA;
+    } else if (graph_density(g) >= APSP_DENSITY && g->nvertices <= APSP_MAX_VERTICES
+        && integral_weights(g)) {
+      engine = DD_FLOYD;
+    } else {
+      engine = DD_BATCH;
+    }
+  }
+
+  // pairs in different components are never counted
+  components cc;
+  find_components(g, &cc, g->nthreads);
+
+  if (engine == DD_FLOYD) {
+    size_t stride = apsp_stride(g->nvertices);
+    double *dists = calloc(stride * stride, sizeof(double));
+    assert(dists);
+    floyd_warshall(g, dists, g->nthreads);
+
+    // row i holds the distances from vertex i
+    for (size_t i = 0; i + 1 < g->nvertices; i++) {
+      size_t s = graph_vertex(g, i);
+      const double *row = &dists[s * stride];
+      for (size_t j = i + 1; j < g->nvertices; j++) {
+        size_t v = graph_vertex(g, j);
+        if (cc.id[v] != cc.id[s]) continue;
+        dd_count(ht, row[v]);
+      }
+    }
+
+    free(dists);
+    components_destroy(&cc);
+    return;
+  }
+
+  if (engine == DD_BATCH) {
+    double *dists = calloc(g->nvertices * SSSP_BATCH, sizeof(double));
+    assert(dists);
+    size_t sources[SSSP_BATCH];
+
+    // pairs are counted in the same order as the dijkstra engine,
+    // so the table comes out identical
+    for (size_t i = 0; i + 1 < g->nvertices; i += SSSP_BATCH) {
+      size_t k = 0;
+      while (k < SSSP_BATCH && i + k + 1 < g->nvertices) {
+        sources[k] = graph_vertex(g, i + k);
+        k++;
+      }
+      sssp_batch(g, sources, k, dists);
+      for (size_t l = 0; l < k; l++) {
+        for (size_t j = i + l + 1; j < g->nvertices; j++) {
+          size_t v = graph_vertex(g, j);
+          if (cc.id[v] != cc.id[sources[l]]) continue;
+          dd_count(ht, dists[v * SSSP_BATCH + l]);
+        }
+      }
+    }
+
+    free(dists);
+    components_destroy(&cc);
+    return;
+  }
+
   double *dists = calloc(g->nvertices, sizeof(double));
   int *prev = calloc(g->nvertices, sizeof(int));
+  priority_queue *pq = pq_init(calloc(1, sizeof(priority_queue)), g->nvertices + 1);
+  // members of each component already used as sources
+  size_t *done = calloc(cc.count, sizeof(size_t));
+  assert(dists && prev && done);
 
+  // pairs in order of original ids, whatever the vertex order.
+  // Members are sorted by original id, so the pairs of source i are
+  // the members after it in its component.
   for (size_t i = 0; i < g->nvertices - 1; i++) {
-    dijkstra(g, i, dists, prev);
-    for (size_t j = i + 1; j < g->nvertices; j++) {
+    size_t s = graph_vertex(g, i);
+    size_t c = cc.id[s];
+    const size_t *members = component_vertices(&cc, c);
+    size_t count = component_size(&cc, c);
+    size_t first = ++done[c];
+    if (first == count) continue;
+    dijkstra_subset(g, s, members, count, dists, prev, pq);
+    for (size_t k = first; k < count; k++) {
       // update distance count for dists[j]
-      size_t tmp = 0;
-      if (ht_get_value(ht, &dists[j], &tmp)) {
-        // add one to existing entry
-        size_t new = tmp + 1;
-        ht_set_value(ht, &dists[j], &new);
-      } else {
-        // add new entry
-        tmp = 1;
-        ht_insert(ht, &dists[j], &tmp);
-      }
+      dd_count(ht, dists[members[k]]);
     }
   }
 
   free(dists);
   free(prev);
+  free(done);
+  pq_destroy(pq);
+  free(pq);
+  components_destroy(&cc);
 }
-
-
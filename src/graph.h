@@ -2,6 +2,13 @@
 
 #define MAX 1000000
 #define INF INT_MAX
+// Number of sources searched together by sssp_batch()
+#define SSSP_BATCH 8
+
+// Fraction of possible edges from which spanning trees use prim_dense()
+#define PRIM_DENSITY 0.05
+// Keys compared at once by the prim_dense() minimum scan
+#define PRIM_LANES 8
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,6 +17,8 @@
 #include <limits.h>
 #include "priority_queue.h" // for Dijkstra, Prim
 #include "hash_table.h" // for distance distribution
+#include "arena.h" // edge storage
+#include "deque.h" // label-correcting work queue
 
 typedef struct edgenode {
   // next edge
@@ -20,6 +29,8 @@ typedef struct edgenode {
   double weight;
 } edgenode;
 
+// Frees a standalone edge list allocated with calloc().
+// Edges of a graph live in its arena and are released by destroy_graph().
 void destroy_list(edgenode *v);
 
 typedef struct graph {
@@ -29,8 +40,32 @@ typedef struct graph {
   size_t nvertices;
   size_t nedges;
   bool directed;
+  // whether every edge weighs 1, in which case searches run bfs()
+  bool unit_weights;
+  // threads available to parallel algorithms, 1 by default
+  size_t nthreads;
+  // backing storage for edgenodes
+  arena pool;
+  // original id of each vertex once relabel_graph() ran, NULL before
+  size_t *label;
+  // vertex holding each original id, the inverse of label
+  size_t *index;
+  // edges moved out of the lists by compact_graph(), NULL before
+  struct compact_edges *compact;
+  // edges moved out of the lists by packed_graph(), NULL before
+  struct packed_edges *packed;
 } graph;
 
+// Vertex of g holding the original id
+static inline size_t graph_vertex(const graph *g, size_t id) {
+  return g->index ? g->index[id] : id;
+}
+
+// Original id of vertex v of g
+static inline size_t graph_label(const graph *g, size_t v) {
+  return g->label ? g->label[v] : v;
+}
+
 // Initializes graph g with attributes
 graph *init_graph(graph *g, size_t nvertices, size_t nedges, bool directed);
 
@@ -40,19 +75,92 @@ void destroy_graph(graph *g);
 // Inserts directed or non-directed edge (x, y) with weight w in graph g.
 void insert_edge(graph *g, size_t x, size_t y, double w, bool directed);
 
+// Edge (x, y) with weight w, as passed to insert_edges()
+typedef struct edge {
+  size_t x;
+  size_t y;
+  double weight;
+} edge;
+
+// Same as insert_edge() on each of the n edges in order, with the
+// degrees counted first so the new edgenodes take one allocation and
+// each vertex's share of them is contiguous.
+void insert_edges(graph *g, const edge edges[], size_t n, bool directed);
+
 // Prints graph g
 void print_graph(graph *g);
 
+// Fraction of possible edges present: adjacency entries over ordered
+// vertex pairs, which counts an undirected edge once per direction.
+// 0 for graphs of fewer than two vertices.
+double graph_density(const graph *g);
+
+// Hash of g's vertices and edges, identifies the graph in files and caches
+uint64_t graph_fingerprint(graph *g);
+
+// Edges dropped by canonicalize_graph(), counted as inserted
+// (an undirected edge once)
+typedef struct canon_stats {
+  size_t parallel;
+  size_t loops;
+} canon_stats;
+
+// Keeps only the lightest of parallel edges between two vertices and drops
+// self-loops, then packs the remaining edges contiguously. Shortest paths
+// and spanning trees are unchanged. removed may be NULL.
+void canonicalize_graph(graph *g, canon_stats *removed);
+
 // dijkstra path search.
 // dist[i] = d(source, i)
 // prev stores paths
+// Graphs with unit weights are searched with bfs() instead.
 void dijkstra(graph *g, size_t source, double dist[], int prev[]);
 
+// Same as dijkstra(), reusing pq, which must hold more than nvertices
+// elements. Lets repeated searches skip setting up a queue.
+void dijkstra_pq(graph *g, size_t source, double dist[], int prev[], priority_queue *pq);
+
 // prim's algorithm (minimum spanning tree)
 // stores tree's edges on vertices
 // stores edges' cost on keys
 void prim(graph *g, int parents[], double keys[]);
 
+// Same as prim(), reusing pq, which must hold nvertices elements
+void prim_pq(graph *g, int parents[], double keys[], priority_queue *pq);
+
+// dijkstra_pq() and prim_pq() over the count vertices in members only,
+// NULL for vertices 0 .. count - 1. Entries of other vertices are left
+// as they are, except that bfs() fills every entry. members must hold
+// every vertex reachable from source, as a connected component does.
+void dijkstra_subset(graph *g, size_t source, const size_t members[], size_t count,
+    double dist[], int prev[], priority_queue *pq);
+void prim_subset(graph *g, size_t source, const size_t members[], size_t count,
+    int parents[], double keys[], priority_queue *pq);
+
+// O(V^2) prim() for dense undirected graphs: each step scans an array
+// of keys for its minimum instead of keeping a heap. Grows one tree per
+// root, starting the next root once the frontier runs out, so roots
+// must hold a vertex of each component, in the order trees are wanted.
+void prim_dense(graph *g, const size_t roots[], size_t nroots, int parents[], double keys[]);
+
+// Shortest distances from up to SSSP_BATCH sources in a single
+// label-correcting pass, so each edge is loaded once per batch.
+// dist holds nvertices * SSSP_BATCH entries: dist[v * SSSP_BATCH + k] = d(sources[k], v).
+// Lanes past k are left at INF.
+void sssp_batch(graph *g, const size_t sources[], size_t k, double dist[]);
+
+// Algorithms distance_distribution() may run
+typedef enum dd_engine {
+  DD_AUTO,     // pick one for the graph
+  DD_DIJKSTRA, // dijkstra() from every source
+  DD_BATCH,    // sssp_batch() over SSSP_BATCH sources at a time
+  DD_FLOYD     // floyd_warshall() over a dense distance matrix
+} dd_engine;
+
 // Calculates distance distribution for all distances.
 void distance_distribution(graph *g, hash_table *ht);
 
+// Same as distance_distribution(), with the given algorithm.
+// All engines produce the same table.
+void distance_distribution_engine(graph *g, hash_table *ht, dd_engine engine);
+
@@ -0,0 +1,562 @@
+#include "graph_io.h"
+#include <ctype.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vector.h"
+
+size_t lines(FILE *f) {
+  size_t lines = 0;
+  while(!feof(f)) {
+    int ch = fgetc(f);
+    if(ch == '\n') {
+      lines++;
+    }
+  }
+  rewind(f);
+  return lines;
+}
+
+graph *read_graph(const char *restrict filename, graph *g) {
+  assert(g);
+
+  FILE *f = fopen(filename, "r");
+  if (!f) {
+    printf("Error: could not read file '%s'. Exiting.\n", filename);
+    exit(EXIT_FAILURE);
+  }
+
+  size_t nedges = lines(f) - 1;
+
+  int nvertices;
+
+  fscanf(f, "%d", &nvertices);
+
+  if (nvertices <= 0) {
+    printf("Invalid vertex count '%d'. Exiting.\n", nvertices);
+    exit(EXIT_FAILURE);
+  }
+
+  init_graph(g, (size_t) nvertices, nedges, false);
+
+  // edges are inserted together once all are read
+  Vector *batch = initVector(NULL, sizeof(edge));
+  vectorReserve(batch, nedges);
+
+  for (size_t i = 0; i < nedges; i++) {
+    int x, y;
+    double w;
+    fscanf(f, "%d %d %lf", &x, &y, &w);
+    // assumes 1 indexing of vertices and positive weights
+    // check if values are inside bounds
+    if (x <= 0) {
+      printf("Error processing edge (%d, %d, %f). Invalid point '%d'. Exiting.\n", x, y, w, x);
+      exit(EXIT_FAILURE);
+    }
+
+    if (y <= 0) {
+      printf("Error processing edge (%d, %d, %f). Invalid point '%d'. Exiting.\n", x, y, w, y);
+      exit(EXIT_FAILURE);
+    }
+
+    if (w < 0.0) {
+      printf("Error processing edge (%d, %d, %f). Invalid weight '%f'. Exiting.\n", x, y, w, w);
+      exit(EXIT_FAILURE);
+    }
+
+    edge e = {(size_t) x-1, (size_t) y-1, w}; // -1 (0 index for storage)
+    vectorPushBack(batch, &e);
+  }
+
+  fclose(f);
+  insert_edges(g, vectorData(batch), vectorCount(batch), false);
+  deinitVector(batch);
+
+  return g;
+}
+
+// What went wrong on the first bad line of a chunk
+typedef enum load_error {
+  LOAD_OK,
+  LOAD_MALFORMED, // not three numbers
+  LOAD_POINT_X,   // x out of range
+  LOAD_POINT_Y,   // y out of range
+  LOAD_WEIGHT     // negative weight
+} load_error;
+
+// Work of one loader thread
+typedef struct load_task {
+  // lines [begin, end) of the mapped file
+  const char *begin;
+  const char *end;
+  size_t nvertices;
+  // parsed edges in file order
+  edge *edges;
+  size_t nedges;
+  // first bad line and its values
+  load_error error;
+  int ex, ey;
+  double ew;
+  // edges per vertex (count phase), then the next slot of each vertex
+  // taken by this chunk's edges (scatter phase)
+  size_t *slots;
+  // shared state for the later phases
+  const size_t *offsets;
+  edgenode *nodes;
+  edgenode **heads;
+  size_t first_vertex;
+  size_t last_vertex;
+  struct load_task *all;
+  size_t ntasks;
+} load_task;
+
+// Parses an int like "%d" at *p, skipping blanks. Returns false if there is none.
+static bool parse_int(const char **p, const char *end, int *out) {
+  const char *s = *p;
+  while (s < end && (*s == ' ' || *s == '\t' || *s == '\r')) s++;
+  bool negative = false;
+  if (s < end && (*s == '-' || *s == '+')) {
+    negative = *s == '-';
+    s++;
+  }
+  if (s == end || !isdigit((unsigned char) *s)) return false;
+  long long v = 0;
+  while (s < end && isdigit((unsigned char) *s)) {
+    if (v < INT_MAX) {
+      v = v * 10 + (*s - '0');
+    }
+    s++;
+  }
+  if (v > INT_MAX) v = INT_MAX;
+  *out = (int) (negative ? -v : v);
+  *p = s;
+  return true;
+}
+
+// Parses a double like "%lf" at *p. Plain integers are converted directly,
+// anything else goes through strtod() on a terminated copy of the token.
+static bool parse_double(const char **p, const char *end, double *out) {
+  const char *s = *p;
+  while (s < end && (*s == ' ' || *s == '\t' || *s == '\r')) s++;
+  const char *t = s;
+  while (t < end && !isspace((unsigned char) *t)) t++;
+  if (t == s) return false;
+
+  size_t len = (size_t) (t - s);
+  bool digits = len < 16;
+  for (size_t i = 0; digits && i < len; i++) {
+    digits = isdigit((unsigned char) s[i]);
+  }
+  if (digits) {
+    // exact, up to 15 digits fit a double's mantissa
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+      v = v * 10 + (uint64_t) (s[i] - '0');
+    }
+    *out = (double) v;
+  } else {
+    char token[64];
+    if (len >= sizeof(token)) return false;
+    memcpy(token, s, len);
+    token[len] = '\0';
+    char *stop;
+    *out = strtod(token, &stop);
+    if (*stop != '\0') return false;
+  }
+  *p = t;
+  return true;
+}
+
+static void *load_parse(void *arg) {
+  load_task *t = arg;
+  // at most one edge per line
+  size_t max = 0;
+  for (const char *p = t->begin; p < t->end; p++) {
+    max += *p == '\n';
+  }
+  t->edges = malloc((max + 1) * sizeof(edge));
+  assert(t->edges);
+
+  for (const char *p = t->begin; p < t->end;) {
+    const char *eol = memchr(p, '\n', (size_t) (t->end - p));
+    if (!eol) eol = t->end;
+
+    int x, y;
+    double w;
+    const char *q = p;
+    bool blank = true;
+    for (const char *c = p; c < eol && blank; c++) {
+      blank = isspace((unsigned char) *c);
+    }
+    if (blank) {
+      p = eol + 1;
+      continue;
+    }
+
+    if (!parse_int(&q, eol, &x) || !parse_int(&q, eol, &y) || !parse_double(&q, eol, &w)) {
+      t->error = LOAD_MALFORMED;
+      return NULL;
+    }
+    t->ex = x;
+    t->ey = y;
+    t->ew = w;
+    if (x <= 0 || (size_t) x > t->nvertices) {
+      t->error = LOAD_POINT_X;
+      return NULL;
+    }
+    if (y <= 0 || (size_t) y > t->nvertices) {
+      t->error = LOAD_POINT_Y;
+      return NULL;
+    }
+    if (w < 0.0) {
+      t->error = LOAD_WEIGHT;
+      return NULL;
+    }
+
+    // -1 (0 index for storage)
+    t->edges[t->nedges++] = (edge) {(size_t) x - 1, (size_t) y - 1, w};
+    p = eol + 1;
+  }
+  return NULL;
+}
+
+static void *load_count(void *arg) {
+  load_task *t = arg;
+  t->slots = calloc(t->nvertices, sizeof(size_t));
+  assert(t->slots);
+  for (size_t i = 0; i < t->nedges; i++) {
+    t->slots[t->edges[i].x]++;
+    t->slots[t->edges[i].y]++;
+  }
+  return NULL;
+}
+
+// Turns the per-chunk counts of a range of vertices into the first slot
+// each chunk writes, chunks in file order
+static void *load_prefix(void *arg) {
+  load_task *t = arg;
+  for (size_t v = t->first_vertex; v < t->last_vertex; v++) {
+    size_t next = t->offsets[v];
+    for (size_t c = 0; c < t->ntasks; c++) {
+      size_t count = t->all[c].slots[v];
+      t->all[c].slots[v] = next;
+      next += count;
+    }
+  }
+  return NULL;
+}
+
+// insert_edge() pushes to the front, so the list of v runs from its last
+// edge in the file to its first: slot k is stored at the segment's end - k
+static void *load_scatter(void *arg) {
+  load_task *t = arg;
+  for (size_t i = 0; i < t->nedges; i++) {
+    const edge *e = &t->edges[i];
+    size_t vs[2] = {e->x, e->y};
+    size_t ys[2] = {e->y, e->x};
+    for (int k = 0; k < 2; k++) {
+      size_t v = vs[k];
+      size_t slot = t->slots[v]++;
+      edgenode *node = &t->nodes[t->offsets[v + 1] - 1 - (slot - t->offsets[v])];
+      node->y = ys[k];
+      node->weight = e->weight;
+    }
+  }
+  return NULL;
+}
+
+static void *load_link(void *arg) {
+  load_task *t = arg;
+  for (size_t v = t->first_vertex; v < t->last_vertex; v++) {
+    size_t first = t->offsets[v], last = t->offsets[v + 1];
+    for (size_t i = first; i + 1 < last; i++) {
+      t->nodes[i].next = &t->nodes[i + 1];
+    }
+    if (last > first) {
+      t->nodes[last - 1].next = NULL;
+      t->heads[v] = &t->nodes[first];
+    }
+  }
+  return NULL;
+}
+
+// Runs fn over tasks[0..n), the calling thread taking the first one
+static void load_run(void *(*fn)(void *), load_task tasks[], size_t n) {
+  pthread_t *threads = n > 1 ? calloc(n, sizeof(pthread_t)) : NULL;
+  for (size_t i = 1; i < n; i++) {
+    int err = pthread_create(&threads[i], NULL, fn, &tasks[i]);
+    assert(err == 0);
+    (void) err;
+  }
+  fn(&tasks[0]);
+  for (size_t i = 1; i < n; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+}
+
+// Builds the adjacency lists of g from the parsed chunks, like
+// insert_edges() with each phase shared out among the threads
+static void load_build(graph *g, load_task tasks[], size_t nthreads, size_t nedges) {
+  size_t n = g->nvertices;
+  load_run(load_count, tasks, nthreads);
+
+  size_t *offsets = calloc(n + 1, sizeof(size_t));
+  assert(offsets);
+  for (size_t v = 0; v < n; v++) {
+    size_t degree = 0;
+    for (size_t i = 0; i < nthreads; i++) {
+      degree += tasks[i].slots[v];
+    }
+    g->degree[v] = degree;
+    offsets[v + 1] = offsets[v] + degree;
+  }
+
+  // every edge is stored in both directions, in one block of the arena
+  edgenode *nodes = arena_alloc(&g->pool, (offsets[n] ? offsets[n] : 1) * sizeof(edgenode));
+  for (size_t i = 0; i < nthreads; i++) {
+    tasks[i].offsets = offsets;
+    tasks[i].nodes = nodes;
+    tasks[i].heads = g->edges;
+    tasks[i].first_vertex = n * i / nthreads;
+    tasks[i].last_vertex = n * (i + 1) / nthreads;
+  }
+  load_run(load_prefix, tasks, nthreads);
+  load_run(load_scatter, tasks, nthreads);
+  load_run(load_link, tasks, nthreads);
+
+  for (size_t i = 0; i < nthreads && g->unit_weights; i++) {
+    for (size_t e = 0; e < tasks[i].nedges; e++) {
+      if (tasks[i].edges[e].weight != 1.0) {
+        g->unit_weights = false;
+        break;
+      }
+    }
+  }
+  // insert_edge() counts each undirected edge once more
+  g->nedges += nedges;
+  free(offsets);
+}
+
+graph *load_graph(const char *restrict filename, graph *g, size_t nthreads) {
+  assert(g);
+  if (nthreads == 0) nthreads = 1;
+
+  int fd = open(filename, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    printf("Error: could not read file '%s'. Exiting.\n", filename);
+    exit(EXIT_FAILURE);
+  }
+  size_t size = (size_t) st.st_size;
+  const char *data = size > 0 ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : "";
+  if (data == MAP_FAILED) {
+    printf("Error: could not read file '%s'. Exiting.\n", filename);
+    exit(EXIT_FAILURE);
+  }
+  const char *end = data + size;
+
+  // vertex count on the first line
+  const char *p = data;
+  int nvertices = 0;
+  while (p < end && isspace((unsigned char) *p)) p++;
+  parse_int(&p, end, &nvertices);
+  if (nvertices <= 0) {
+    printf("Invalid vertex count '%d'. Exiting.\n", nvertices);
+    exit(EXIT_FAILURE);
+  }
+  const char *eol = memchr(p, '\n', (size_t) (end - p));
+  p = eol ? eol + 1 : end;
+
+  // chunks of about equal size, cut after a newline
+  load_task *tasks = calloc(nthreads, sizeof(load_task));
+  assert(tasks);
+  size_t per = (size_t) (end - p) / nthreads + 1;
+  for (size_t i = 0; i < nthreads; i++) {
+    tasks[i].begin = i == 0 ? p : tasks[i - 1].end;
+    const char *cut = tasks[i].begin + per < end ? tasks[i].begin + per : end;
+    const char *nl = i + 1 < nthreads && cut < end ? memchr(cut, '\n', (size_t) (end - cut)) : NULL;
+    tasks[i].end = i + 1 == nthreads ? end : (nl ? nl + 1 : end);
+    tasks[i].nvertices = (size_t) nvertices;
+    tasks[i].all = tasks;
+    tasks[i].ntasks = nthreads;
+  }
+  load_run(load_parse, tasks, nthreads);
+
+  // the first bad line in the file is reported, as a sequential read would
+  size_t nedges = 0;
+  for (size_t i = 0; i < nthreads; i++) {
+    load_task *t = &tasks[i];
+    nedges += t->nedges;
+    switch (t->error) {
+      case LOAD_OK:
+        continue;
+      case LOAD_MALFORMED:
+        printf("Error processing edge %zu. Expected 'x y weight'. Exiting.\n", nedges + 1);
+        break;
+      case LOAD_POINT_X:
+        printf("Error processing edge (%d, %d, %f). Invalid point '%d'. Exiting.\n", t->ex, t->ey, t->ew, t->ex);
+        break;
+      case LOAD_POINT_Y:
+        printf("Error processing edge (%d, %d, %f). Invalid point '%d'. Exiting.\n", t->ex, t->ey, t->ew, t->ey);
+        break;
+      case LOAD_WEIGHT:
+        printf("Error processing edge (%d, %d, %f). Invalid weight '%f'. Exiting.\n", t->ex, t->ey, t->ew, t->ew);
+        break;
+    }
+    exit(EXIT_FAILURE);
+  }
+
+  init_graph(g, (size_t) nvertices, nedges, false);
+  if (nthreads == 1) {
+    // nothing to share out, the batch insert builds the same lists
+    insert_edges(g, tasks[0].edges, tasks[0].nedges, false);
+  } else {
+    load_build(g, tasks, nthreads, nedges);
+  }
+
+  for (size_t i = 0; i < nthreads; i++) {
+    free(tasks[i].edges);
+    free(tasks[i].slots);
+  }
+  free(tasks);
+  if (size > 0) {
+    munmap((void *) data, size);
+  }
+  close(fd);
+
+  return g;
+}
+
+void path(graph *g, size_t a, size_t b,
+  double dists[], int prev[], writer *w) {
+  assert(a < g->nvertices);
+  assert(b < g->nvertices);
+  writer_str(w, "d(");
+  writer_uint(w, graph_label(g, a) + 1);
+  writer_str(w, ", ");
+  writer_uint(w, graph_label(g, b) + 1);
+  writer_str(w, ") = ");
+  writer_fixed(w, dists[b]);
+  writer_str(w, ", [");
+
+  int curr = (int) b;
+  while (curr >= 0 && curr != (int) a) {
+    writer_uint(w, graph_label(g, (size_t) curr) + 1);
+    writer_str(w, ", ");
+    curr = prev[curr];
+  }
+  writer_uint(w, graph_label(g, a) + 1);
+  writer_str(w, "]\n");
+}
+
+void print_tree(graph *g, size_t a, double dists[], int prev[], writer *w) {
+  assert(a < g->nvertices);
+  writer_uint(w, g->nvertices);
+  writer_char(w, '\n');
+  for (size_t i = 0; i < g->nvertices; i++) {
+    size_t v = graph_vertex(g, i);
+    if (v == a) continue;
+    writer_uint(w, i + 1);
+    writer_char(w, ' ');
+    writer_uint(w, prev[v] >= 0 ? graph_label(g, (size_t) prev[v]) + 1 : 0);
+    writer_char(w, ' ');
+    writer_fixed(w, dists[v]);
+    writer_char(w, '\n');
+  }
+}
+
+
+void print_mst(graph *g, const components *cc, int parents[], double keys[], writer *w) {
+  writer_uint(w, g->nvertices);
+  writer_char(w, '\n');
+
+  double total_cost = 0.0;
+  for (size_t i = 0; i < g->nvertices; i++) {
+    size_t v = graph_vertex(g, i);
+    if (parents[v] == -1) continue;
+    total_cost += keys[v];
+    writer_uint(w, i + 1);
+    writer_char(w, ' ');
+    writer_uint(w, graph_label(g, (size_t) parents[v]) + 1);
+    writer_char(w, ' ');
+    writer_fixed(w, keys[v]);
+    writer_char(w, '\n');
+  }
+
+  writer_str(w, "Total cost: ");
+  writer_fixed(w, total_cost);
+  writer_char(w, '\n');
+
+  // a forest also reports its trees, by their first vertex
+  if (!cc || cc->count < 2) return;
+  writer_printf(w, "Components: %zu\n", cc->count);
+  for (size_t c = 0; c < cc->count; c++) {
+    const size_t *members = component_vertices(cc, c);
+    double cost = 0.0;
+    for (size_t k = 0; k < component_size(cc, c); k++) {
+      if (parents[members[k]] != -1) cost += keys[members[k]];
+    }
+    writer_printf(w, "Component %zu: %zu vertices, cost %f\n",
+        graph_label(g, members[0]) + 1, component_size(cc, c), cost);
+  }
+}
+
+void print_distribution(graph *g, hash_table *ht, writer *w) {
+  // get data on a easier to iterate on format
+  double *dists = calloc(ht->count, sizeof(double));
+  size_t *counts = calloc(ht->count, sizeof(size_t));
+  ht_arrays(ht, (uint8_t *) dists, (uint8_t *) counts);
+
+  writer_str(w, "Distance distribution:\n");
+
+  // total possible unordered vertex pairs
+  double total = (double) g->nvertices * ((double) g->nvertices - 1.0) / 2.0;
+
+  size_t reached = 0;
+  for (size_t i = 0; i < ht->count; i++) {
+    double frac = (double) counts[i]/ total;
+    writer_fixed(w, dists[i]);
+    writer_str(w, ": ");
+    writer_fixed(w, frac);
+    writer_char(w, '\n');
+    reached += counts[i];
+  }
+
+  // pairs with no path between them, e.g. in different components
+  if ((double) reached < total) {
+    writer_printf(w, "unreachable: %f\n", ((double) total - (double) reached) / total);
+  }
+
+  free(dists);
+  free(counts);
+}
+
+void print_estimate(graph *g, dd_estimate *est, writer *w) {
+  size_t count = est->table.count;
+  double *dists = calloc(count, sizeof(double));
+  dd_moments *moments = calloc(count, sizeof(dd_moments));
+  assert(dists && moments);
+  ht_arrays(&est->table, (uint8_t *) dists, (uint8_t *) moments);
+
+  writer_printf(w, "Distance distribution (estimated from %zu of %zu sources, %d%% confidence):\n",
+      est->samples, g->nvertices, ESTIMATE_CONFIDENCE);
+
+  for (size_t i = 0; i < count; i++) {
+    double error;
+    double frac = estimate_fraction(est, &moments[i], &error);
+    writer_printf(w, "%f: %f +- %f\n", dists[i], frac, error);
+  }
+
+  double error;
+  double frac = estimate_fraction(est, &est->unreachable, &error);
+  if (frac > 0) {
+    writer_printf(w, "unreachable: %f +- %f\n", frac, error);
+  }
+
+  free(dists);
+  free(moments);
+}
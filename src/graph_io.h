@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdio.h>
+#include "graph.h"
+#include "components.h"
+#include "estimate.h"
+#include "writer.h"
+
+// Counts the number of lines in file f.
+size_t lines(FILE *f);
+
+// Reads graph from file at 'filename'.
+// Stops program's execution if anything goes wrong.
+graph *read_graph(const char *restrict filename, graph *g);
+
+// Same as read_graph(), with the file mapped into memory and split at
+// line boundaries among nthreads threads. Each thread parses its chunk,
+// then the adjacency lists are built by a parallel degree count, prefix
+// sum and scatter into one contiguous block of edges. A single thread
+// hands its edges to insert_edges(), which builds them the same way. The graph, down to
+// the order of each adjacency list, and the error messages are those of
+// read_graph().
+graph *load_graph(const char *restrict filename, graph *g, size_t nthreads);
+
+// Prints path between a and b with distance do w
+// dists and prev are output of dijkstra
+// Vertices are printed with their original ids.
+void path(graph *g, size_t a, size_t b,
+    double dists[], int prev[], writer *w);
+
+// Prints the shortest path tree from a once instead of every path:
+// the vertex count, then 'v parent distance' for every other vertex,
+// parent 0 if v is unreachable
+void print_tree(graph *g, size_t a, double dists[], int prev[], writer *w);
+
+// Prints the spanning tree found by prim() and its total cost to w.
+// With cc of more than one component, the cost of each tree follows.
+void print_mst(graph *g, const components *cc, int parents[], double keys[], writer *w);
+
+// Prints the table filled by distance_distribution() to w,
+// as fractions of all vertex pairs, followed by the fraction of pairs
+// without a path if there are any
+void print_distribution(graph *g, hash_table *ht, writer *w);
+
+// Prints the distribution estimated by estimate_distribution() to w,
+// each fraction followed by the half width of its confidence interval
+void print_estimate(graph *g, dd_estimate *est, writer *w);
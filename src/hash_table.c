@@ -1,4 +1,5 @@
 #include "hash_table.h"
+#include "stats.h"
 
 __ht_entry *__ht_entry_init(__ht_entry *entry, hash_table *ht, const void *key,
     const void *value, __ht_entry *next) {
@@ -28,6 +29,41 @@ __ht_entry *__ht_entry_destroy(__ht_entry *entry) {
   return entry->next;
 }
 
+// Entries allocated from an arena hold their key and value inline
+static inline size_t __ht_key_offset(void) {
+  return (sizeof(__ht_entry) + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1);
+}
+
+static inline size_t __ht_value_offset(hash_table *ht) {
+  return __ht_key_offset() + ((ht->key_size + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1));
+}
+
+static __ht_entry *__ht_entry_new(hash_table *ht, const void *key,
+    const void *value, __ht_entry *next) {
+  if (!ht->pool) {
+    return __ht_entry_init(calloc(1, sizeof(__ht_entry)), ht, key, value, next);
+  }
+
+  uint8_t *chunk = arena_alloc(ht->pool, __ht_value_offset(ht) + ht->value_size);
+  __ht_entry *entry = (__ht_entry *) chunk;
+  entry->key = chunk + __ht_key_offset();
+  memcpy(entry->key, key, ht->key_size);
+  entry->value = chunk + __ht_value_offset(ht);
+  memcpy(entry->value, value, ht->value_size);
+  entry->next = next;
+  return entry;
+}
+
+static void __ht_entry_free(hash_table *ht, __ht_entry *entry) {
+  if (!ht->pool) {
+    __ht_entry_destroy(entry);
+    free(entry);
+    return;
+  }
+
+  arena_free(ht->pool, entry, __ht_value_offset(ht) + ht->value_size);
+}
+
 hash_table *ht_init(hash_table *ht, size_t key_size,
                     size_t value_size, size_t max) {
   assert(ht);
@@ -38,6 +74,7 @@ hash_table *ht_init(hash_table *ht, size_t key_size,
   ht->key_size = key_size;
   ht->hash_func = s_hash; // standard hash
   ht->kcomp = s_comp;  // standard comp
+  ht->pool = NULL;
   ht->entries = calloc(max, sizeof(__ht_entry *));
   assert(ht->entries);
   return ht;
@@ -46,7 +83,8 @@ hash_table *ht_init(hash_table *ht, size_t key_size,
 void ht_destroy(hash_table *ht) {
   assert(ht);
 
-  for (size_t i = 0; i < ht->max; i++) {
+  // entries in an arena are released with it
+  for (size_t i = 0; !ht->pool && i < ht->max; i++) {
     __ht_entry *ptr = ht->entries[i];
     while (ptr) {
       __ht_entry *tmp = ptr->next;
@@ -62,12 +100,14 @@ void ht_destroy(hash_table *ht) {
   ht->value_size = 0;
   ht->hash_func = 0;
   ht->kcomp = 0;
+  ht->pool = 0;
 
   free(ht->entries);
 }
 
 
 void ht_set_value(hash_table *ht, const void *key, const void *value) {
+  STATS_COUNT(ST_HT_SET);
   assert(ht);
   assert(key);
   assert(value);
@@ -85,6 +125,7 @@ void ht_set_value(hash_table *ht, const void *key, const void *value) {
 }
 
 void ht_insert(hash_table *ht, const void *key, const void *value) {
+  STATS_COUNT(ST_HT_INSERT);
   assert(ht);
   assert(key);
   assert(value);
@@ -94,12 +135,13 @@ void ht_insert(hash_table *ht, const void *key, const void *value) {
   __ht_entry *ptr = ht->entries[i];
 
   // insert in the beginning of the list
-  __ht_entry *e = __ht_entry_init(calloc(1, sizeof(__ht_entry)), ht, key, value, ptr);
+  __ht_entry *e = __ht_entry_new(ht, key, value, ptr);
   ht->entries[i] = e;
   ht->count += 1;
 }
 
 void ht_remove(hash_table *ht, const void *key) {
+  STATS_COUNT(ST_HT_REMOVE);
   assert(ht);
 
   size_t i = ht->hash_func(key) % ht->max;
@@ -118,13 +160,13 @@ void ht_remove(hash_table *ht, const void *key) {
     // since prev is NULL, we're removing the first element
     ht->entries[i] = ptr->next;
   }
-  __ht_entry_destroy(ptr);
-  free(ptr);
+  __ht_entry_free(ht, ptr);
 
   ht->count -= 1;
 }
 
 bool ht_get_value(hash_table *ht, const void *key, void *value) {
+  STATS_COUNT(ST_HT_GET);
   assert(ht);
   assert(key);
 
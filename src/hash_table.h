@@ -8,6 +8,7 @@
 #include <assert.h>
 #include <math.h>
 #include <float.h>
+#include "arena.h"
 
 // Default table size
 #define HT_DEFAULT_SIZE 5201
@@ -35,6 +36,10 @@ typedef struct hash_table {
   size_t max;
   // number of elements stored
   size_t count;
+  // optional arena for entries, NULL to use the system allocator.
+  // Entries in an arena are not freed one by one on ht_destroy(),
+  // they go away with the arena.
+  arena *pool;
 } hash_table;
 
 __ht_entry *__ht_entry_init(__ht_entry *entry, hash_table *ht, const void *key,
@@ -0,0 +1,140 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+// Intrusive doubly linked list.
+// The link lives inside the user's struct, so inserting and removing never
+// allocates nor copies:
+//
+//   typedef struct job { int id; IListNode link; } job;
+//   IList jobs; initIList(&jobs);
+//   ilistPushBack(&jobs, &j->link);
+//   ILIST_FOR_EACH(n, &jobs) { job *j = ILIST_ENTRY(n, job, link); ... }
+
+typedef struct IListNode {
+  struct IListNode *next;
+  struct IListNode *prev;
+} IListNode;
+
+typedef struct IList {
+  // Sentinel, head.next is the first node and head.prev the last one
+  IListNode head;
+  // Number of linked nodes
+  uint64_t count;
+} IList;
+
+// Pointer to the struct of the given type holding node in its 'member' field
+#define ILIST_ENTRY(node, type, member) \
+  ((type *) ((char *) (node) - offsetof(type, member)))
+
+// Iterates over the nodes of ls
+#define ILIST_FOR_EACH(node, ls) \
+  for (IListNode *node = (ls)->head.next; node != &(ls)->head; node = node->next)
+
+// Iterates over the nodes of ls, node may be removed in the loop body
+#define ILIST_FOR_EACH_SAFE(node, ls) \
+  for (IListNode *node = (ls)->head.next, *node##_next = node->next; \
+       node != &(ls)->head; node = node##_next, node##_next = node->next)
+
+// Initializes an empty list
+static inline IList *initIList(IList *ls) {
+  assert(ls != NULL);
+  ls->head.next = &ls->head;
+  ls->head.prev = &ls->head;
+  ls->count = 0;
+  return ls;
+}
+
+// Links n between prev and next
+static inline void __ilistLink(IListNode *n, IListNode *prev, IListNode *next) {
+  n->prev = prev;
+  n->next = next;
+  prev->next = n;
+  next->prev = n;
+}
+
+// Modifiers
+// Inserts n after the last node
+static inline void ilistPushBack(IList *ls, IListNode *n) {
+  __ilistLink(n, ls->head.prev, &ls->head);
+  ls->count += 1;
+}
+
+// Inserts n before the first node
+static inline void ilistPushFront(IList *ls, IListNode *n) {
+  __ilistLink(n, &ls->head, ls->head.next);
+  ls->count += 1;
+}
+
+// Inserts n right after pos, which is linked in ls
+static inline void ilistInsertAfter(IList *ls, IListNode *pos, IListNode *n) {
+  __ilistLink(n, pos, pos->next);
+  ls->count += 1;
+}
+
+// Inserts n right before pos, which is linked in ls
+static inline void ilistInsertBefore(IList *ls, IListNode *pos, IListNode *n) {
+  __ilistLink(n, pos->prev, pos);
+  ls->count += 1;
+}
+
+// Unlinks n, which must be linked in ls
+static inline void ilistRemove(IList *ls, IListNode *n) {
+  assert(ls->count > 0);
+  n->prev->next = n->next;
+  n->next->prev = n->prev;
+  n->next = NULL;
+  n->prev = NULL;
+  ls->count -= 1;
+}
+
+// Moves every node of src to the end of dst, leaving src empty
+static inline void ilistSplice(IList *dst, IList *src) {
+  if (src->count == 0) return;
+  IListNode *first = src->head.next;
+  IListNode *last = src->head.prev;
+  first->prev = dst->head.prev;
+  dst->head.prev->next = first;
+  last->next = &dst->head;
+  dst->head.prev = last;
+  dst->count += src->count;
+  initIList(src);
+}
+
+// Accessors
+static inline uint64_t ilistCount(const IList *ls) { return ls->count; }
+static inline bool ilistIsEmpty(const IList *ls) { return ls->count == 0; }
+static inline IListNode *ilistFirst(IList *ls) {
+  return ls->count == 0 ? NULL : ls->head.next;
+}
+static inline IListNode *ilistLast(IList *ls) {
+  return ls->count == 0 ? NULL : ls->head.prev;
+}
+// Node following n in ls, NULL at the end
+static inline IListNode *ilistNext(IList *ls, IListNode *n) {
+  return n->next == &ls->head ? NULL : n->next;
+}
+// Node preceding n in ls, NULL at the start
+static inline IListNode *ilistPrev(IList *ls, IListNode *n) {
+  return n->prev == &ls->head ? NULL : n->prev;
+}
+
+// Removes and returns the first node, NULL if ls is empty
+static inline IListNode *ilistPopFront(IList *ls) {
+  IListNode *n = ilistFirst(ls);
+  if (n != NULL) {
+    ilistRemove(ls, n);
+  }
+  return n;
+}
+
+// Removes and returns the last node, NULL if ls is empty
+static inline IListNode *ilistPopBack(IList *ls) {
+  IListNode *n = ilistLast(ls);
+  if (n != NULL) {
+    ilistRemove(ls, n);
+  }
+  return n;
+}
@@ -0,0 +1,206 @@
+#include "landmarks.h"
+#include <string.h>
+#include <math.h>
+
+// File layout: header, k landmark ids, nvertices * k distances
+typedef struct lm_header {
+  char magic[8];
+  uint64_t version;
+  uint64_t nvertices;
+  uint64_t k;
+  uint64_t fingerprint;
+} lm_header;
+
+static const char LM_MAGIC[8] = {'G', 'R', 'A', 'P', 'H', 'A', 'L', 'T'};
+#define LM_VERSION 1
+
+landmarks *lm_build(landmarks *lm, graph *g, size_t k) {
+  assert(lm);
+  assert(g);
+  assert(!g->directed); // bounds below assume d(u, v) = d(v, u)
+
+  size_t n = g->nvertices;
+  if (k > n) {
+    k = n;
+  }
+
+  lm->k = k;
+  lm->nvertices = n;
+  lm->fingerprint = graph_fingerprint(g);
+  lm->vertices = calloc(k, sizeof(size_t));
+  lm->dist = calloc(n * k, sizeof(double));
+  assert(lm->vertices && lm->dist);
+
+  double *dist = calloc(n, sizeof(double));
+  int *prev = calloc(n, sizeof(int));
+  // distance from each vertex to the closest landmark picked so far
+  double *closest = calloc(n, sizeof(double));
+  assert(dist && prev && closest);
+
+  // the first landmark is the vertex farthest from vertex 0
+  dijkstra(g, 0, dist, prev);
+  for (size_t v = 0; v < n; v++) {
+    closest[v] = INF;
+  }
+
+  for (size_t l = 0; l < k; l++) {
+    // farthest reachable vertex from the previous search
+    size_t next = 0;
+    double best = -1;
+    for (size_t v = 0; v < n; v++) {
+      double d = l == 0 ? dist[v] : closest[v];
+      if (d < INF && d > best) {
+        best = d;
+        next = v;
+      }
+    }
+
+    lm->vertices[l] = next;
+    dijkstra(g, next, dist, prev);
+    for (size_t v = 0; v < n; v++) {
+      lm->dist[v * k + l] = dist[v];
+      if (dist[v] < closest[v]) {
+        closest[v] = dist[v];
+      }
+    }
+  }
+
+  free(dist);
+  free(prev);
+  free(closest);
+
+  return lm;
+}
+
+void lm_destroy(landmarks *lm) {
+  assert(lm);
+  free(lm->vertices);
+  free(lm->dist);
+  lm->vertices = NULL;
+  lm->dist = NULL;
+  lm->k = 0;
+  lm->nvertices = 0;
+}
+
+bool lm_save(landmarks *lm, const char *path) {
+  assert(lm);
+  FILE *f = fopen(path, "wb");
+  if (!f) return false;
+
+  lm_header h;
+  memcpy(h.magic, LM_MAGIC, sizeof(h.magic));
+  h.version = LM_VERSION;
+  h.nvertices = lm->nvertices;
+  h.k = lm->k;
+  h.fingerprint = lm->fingerprint;
+
+  bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+  for (size_t l = 0; ok && l < lm->k; l++) {
+    uint64_t v = lm->vertices[l];
+    ok = fwrite(&v, sizeof(v), 1, f) == 1;
+  }
+  ok = ok && fwrite(lm->dist, sizeof(double), lm->nvertices * lm->k, f) == lm->nvertices * lm->k;
+
+  return fclose(f) == 0 && ok;
+}
+
+bool lm_load(landmarks *lm, const char *path, graph *g) {
+  assert(lm);
+  assert(g);
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+
+  lm_header h;
+  if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, LM_MAGIC, sizeof(h.magic)) != 0 ||
+      h.version != LM_VERSION || h.nvertices != g->nvertices || h.k == 0 ||
+      h.k > h.nvertices || h.fingerprint != graph_fingerprint(g)) {
+    fclose(f);
+    return false;
+  }
+
+  lm->k = h.k;
+  lm->nvertices = h.nvertices;
+  lm->fingerprint = h.fingerprint;
+  lm->vertices = calloc(lm->k, sizeof(size_t));
+  lm->dist = calloc(lm->nvertices * lm->k, sizeof(double));
+  assert(lm->vertices && lm->dist);
+
+  bool ok = true;
+  for (size_t l = 0; ok && l < lm->k; l++) {
+    uint64_t v;
+    ok = fread(&v, sizeof(v), 1, f) == 1 && v < lm->nvertices;
+    lm->vertices[l] = ok ? v : 0;
+  }
+  ok = ok && fread(lm->dist, sizeof(double), lm->nvertices * lm->k, f) == lm->nvertices * lm->k;
+  fclose(f);
+
+  if (!ok) {
+    lm_destroy(lm);
+  }
+  return ok;
+}
+
+double lm_lower_bound(landmarks *lm, size_t v, size_t t) {
+  const double *dv = &lm->dist[v * lm->k];
+  const double *dt = &lm->dist[t * lm->k];
+  double bound = 0;
+  for (size_t l = 0; l < lm->k; l++) {
+    // landmarks in another component say nothing
+    if (dv[l] >= INF || dt[l] >= INF) continue;
+    double b = fabs(dt[l] - dv[l]);
+    if (b > bound) {
+      bound = b;
+    }
+  }
+  return bound;
+}
+
+size_t astar(graph *g, landmarks *lm, size_t s, size_t t, double dist[], int prev[]) {
+  assert(g);
+  assert(lm);
+  assert(s < g->nvertices && t < g->nvertices);
+
+  priority_queue *pq = pq_init(calloc(1, sizeof(priority_queue)), g->nvertices + 1);
+  bool *settled = calloc(g->nvertices, sizeof(bool));
+  assert(settled);
+
+  for (size_t i = 0; i < g->nvertices; i++) {
+    dist[i] = INF;
+    prev[i] = -1;
+  }
+
+  // vertices are queued lazily with priority dist + lower bound to t
+  dist[s] = 0;
+  pq_insert(pq, (int) s, lm_lower_bound(lm, s, t));
+
+  size_t nsettled = 0;
+  while (!pq_empty(pq)) {
+    size_t u = (size_t) pq_extract_min(pq);
+    settled[u] = true;
+    nsettled++;
+    if (u == t) break;
+
+    for (edgenode *p = g->edges[u]; p; p = p->next) {
+      if (settled[p->y]) continue;
+
+      double alt = dist[u] + p->weight;
+      if (alt < dist[p->y]) {
+        double estimate = alt + lm_lower_bound(lm, p->y, t);
+        int i = pq_index_of(pq, (int) p->y);
+        if (i < 0) {
+          pq_insert(pq, (int) p->y, estimate);
+        } else {
+          pq_decrease_priority(pq, (size_t) i, estimate);
+        }
+        dist[p->y] = alt;
+        prev[p->y] = (int) u;
+      }
+    }
+  }
+
+  free(settled);
+  pq_destroy(pq);
+  free(pq);
+
+  return nsettled;
+}
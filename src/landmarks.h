@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "graph.h"
+
+// Default number of landmarks
+#define LM_DEFAULT_COUNT 16
+// Suffix of the landmark file stored next to a graph file
+#define LM_FILE_SUFFIX ".alt"
+
+// Distance tables for ALT (A*, landmarks, triangle inequality) queries
+// on undirected graphs
+typedef struct landmarks {
+  // number of landmarks
+  size_t k;
+  size_t nvertices;
+  // landmark vertices
+  size_t *vertices;
+  // dist[v * k + l] = d(vertices[l], v)
+  double *dist;
+  // graph_fingerprint() of the graph the tables belong to
+  uint64_t fingerprint;
+} landmarks;
+
+// Picks k landmarks on g by farthest-point selection and runs a search
+// from each of them
+landmarks *lm_build(landmarks *lm, graph *g, size_t k);
+
+// Frees the tables of lm
+void lm_destroy(landmarks *lm);
+
+// Writes lm to the file at path. Returns whether it succeeded.
+bool lm_save(landmarks *lm, const char *path);
+
+// Reads landmarks for g from the file at path. Returns false if the file
+// is missing, damaged or belongs to another graph.
+bool lm_load(landmarks *lm, const char *path, graph *g);
+
+// Lower bound on d(v, t) from the triangle inequality
+double lm_lower_bound(landmarks *lm, size_t v, size_t t);
+
+// A* search from s to t guided by lm.
+// dist and prev are filled like dijkstra() for the vertices the search
+// settles; dist[t] and the prev chain from t are exact.
+// Returns the number of settled vertices.
+size_t astar(graph *g, landmarks *lm, size_t s, size_t t, double dist[], int prev[]);
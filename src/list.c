@@ -1,7 +1,419 @@
 #include "list.h"
+#include "stats.h"
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
+
+// Unrolled storage
+// Each ListBlock keeps its elements contiguous in data[], so walking the
+// list touches one node per blockCapacity elements.
+
+static inline void *blockSlot(List *ls, ListBlock *b, size_t i) {
+  return b->data + i * ls->size;
+}
+
+static inline size_t blockBytes(List *ls) {
+  return sizeof(ListBlock) + ls->blockCapacity * ls->size;
+}
+
+static ListBlock *newBlock(List *ls, size_t head) {
+  ListBlock *b = arena_or_calloc(ls->pool, blockBytes(ls));
+  assert(b != NULL);
+  b->next = NULL;
+  b->head = head;
+  b->count = 0;
+  return b;
+}
+
+// Unlinks and frees block b, whose predecessor is prev (NULL for the first)
+static void unlinkBlock(List *ls, ListBlock *prev, ListBlock *b) {
+  if (prev == NULL) {
+    ls->firstBlock = b->next;
+  } else {
+    prev->next = b->next;
+  }
+  if (ls->lastBlock == b) {
+    ls->lastBlock = prev;
+  }
+  arena_or_free(ls->pool, b, blockBytes(ls));
+}
+
+// Releases an element that is dropped instead of being copied out
+static inline void releaseElement(List *ls, void *data) {
+  if (ls->deinit != NULL) {
+    ls->deinit(data);
+  }
+}
+
+// Node storage
+// Nodes and element copies come from the list's arena when it has one.
+
+static inline ListNode *newNode(List *ls) {
+  ListNode *n = arena_or_calloc(ls->pool, sizeof(ListNode));
+  assert(n != NULL);
+  return n;
+}
+
+static inline void freeNode(List *ls, ListNode *n) {
+  arena_or_free(ls->pool, n, sizeof(ListNode));
+}
+
+static inline void *newData(List *ls) {
+  return arena_or_calloc(ls->pool, ls->size);
+}
+
+// Releases the element stored by a node and its storage
+static void releaseData(List *ls, void *data) {
+  if (ls->pool != NULL) {
+    releaseElement(ls, data);
+    arena_free(ls->pool, data, ls->size);
+  } else if (ls->deinit == NULL) {
+    free(data);
+  } else {
+    ls->deinit(data);
+  }
+}
+
+static void unrolledAppend(List *ls, void *element) {
+  ListBlock *b = ls->lastBlock;
+  if (b == NULL || b->head + b->count == ls->blockCapacity) {
+    ListBlock *n = newBlock(ls, 0);
+    if (b == NULL) {
+      ls->firstBlock = n;
+    } else {
+      b->next = n;
+    }
+    ls->lastBlock = n;
+    b = n;
+  }
+  memcpy(blockSlot(ls, b, b->head + b->count), element, ls->size);
+  b->count += 1;
+  ls->count += 1;
+}
+
+static void unrolledPrepend(List *ls, void *element) {
+  ListBlock *b = ls->firstBlock;
+  if (b == NULL || b->head == 0) {
+    // fill new blocks from the back so further prepends stay in place
+    ListBlock *n = newBlock(ls, ls->blockCapacity);
+    n->next = b;
+    ls->firstBlock = n;
+    if (b == NULL) {
+      ls->lastBlock = n;
+    }
+    b = n;
+  }
+  b->head -= 1;
+  b->count += 1;
+  memcpy(blockSlot(ls, b, b->head), element, ls->size);
+  ls->count += 1;
+}
+
+static void unrolledRemoveFirst(List *ls, void *data) {
+  ListBlock *b = ls->firstBlock;
+  void *p = blockSlot(ls, b, b->head);
+  if (data != NULL) {
+    memcpy(data, p, ls->size);
+  } else {
+    releaseElement(ls, p);
+  }
+  b->head += 1;
+  b->count -= 1;
+  ls->count -= 1;
+  if (b->count == 0) {
+    unlinkBlock(ls, NULL, b);
+  }
+}
+
+static void unrolledRemoveLast(List *ls, void *data) {
+  ListBlock *b = ls->lastBlock;
+  void *p = blockSlot(ls, b, b->head + b->count - 1);
+  if (data != NULL) {
+    memcpy(data, p, ls->size);
+  } else {
+    releaseElement(ls, p);
+  }
+  b->count -= 1;
+  ls->count -= 1;
+  if (b->count == 0) {
+    // blocks are singly linked, find the predecessor
+    ListBlock *prev = NULL;
+    if (ls->firstBlock != b) {
+      prev = ls->firstBlock;
+      while (prev->next != b) {
+        prev = prev->next;
+      }
+    }
+    unlinkBlock(ls, prev, b);
+  }
+}
+
+// Detached iterators
+
+// Moves it to the first element of block b (or past the end)
+static inline void *iterEnterBlock(ListIter *it, ListBlock *b) {
+  it->block = b;
+  if (b == NULL) {
+    it->index = 0;
+    return NULL;
+  }
+  it->index = b->head;
+  return blockSlot(it->list, b, b->head);
+}
+
+// Removes the element under an unrolled iterator, copying it to element
+// or releasing it if element is NULL
+static void iterRemoveUnrolled(ListIter *it, void *element) {
+  List *ls = it->list;
+  ListBlock *b = it->block;
+  size_t i = it->index;
+  void *p = blockSlot(ls, b, i);
+  if (element != NULL) {
+    memcpy(element, p, ls->size);
+  } else {
+    releaseElement(ls, p);
+  }
+
+  if (i == b->head) {
+    // removing the first element of the block, no need to shift
+    b->head += 1;
+    it->index += 1;
+  } else {
+    // shift the tail of the block over the removed element
+    memmove(p, blockSlot(ls, b, i + 1), (b->head + b->count - 1 - i) * ls->size);
+  }
+  b->count -= 1;
+  ls->count -= 1;
+
+  if (b->count == 0) {
+    ListBlock *next = b->next;
+    unlinkBlock(ls, it->previousBlock, b);
+    iterEnterBlock(it, next);
+  } else if (it->index == b->head + b->count) {
+    it->previousBlock = b;
+    iterEnterBlock(it, b->next);
+  }
+}
+
+// Unlinks the node under it and returns the data it stored
+static void *iterUnlinkNode(ListIter *it) {
+  List *ls = it->list;
+  ListNode *n = it->current;
+  void *data = n->data;
+
+  if (it->previous == NULL) {
+    ls->first = n->next;
+  } else {
+    it->previous->next = n->next;
+  }
+  if (ls->last == n) {
+    ls->last = it->previous;
+  }
+  it->current = n->next;
+
+  freeNode(ls, n);
+  ls->count -= 1;
+  return data;
+}
+
+// Removes the element under it and hands it to the caller as heap storage
+static void *iterTake(ListIter *it) {
+  List *ls = it->list;
+  if (it->remaining != UINT64_MAX) {
+    it->remaining -= 1;
+  }
+
+  if (ls->blockCapacity > 0) {
+    assert(it->block != NULL);
+    void *data = calloc(1, ls->size);
+    assert(data != NULL);
+    iterRemoveUnrolled(it, data);
+    return data;
+  }
+
+  assert(it->current != NULL);
+  void *data = iterUnlinkNode(it);
+  if (ls->pool != NULL) {
+    // hand the caller heap storage it can free()
+    void *copy = calloc(1, ls->size);
+    assert(copy != NULL);
+    memcpy(copy, data, ls->size);
+    arena_free(ls->pool, data, ls->size);
+    data = copy;
+  }
+  return data;
+}
+
+void *listIterBegin(ListIter *it, List *ls) {
+  assert(it != NULL);
+  assert(ls != NULL);
+  it->list = ls;
+  it->current = ls->first;
+  it->previous = NULL;
+  it->previousBlock = NULL;
+  it->remaining = UINT64_MAX;
+  if (ls->blockCapacity > 0) {
+    return iterEnterBlock(it, ls->firstBlock);
+  }
+  it->block = NULL;
+  it->index = 0;
+  return listIterGet(it);
+}
+
+void *listIterGet(ListIter *it) {
+  assert(it != NULL);
+  if (it->remaining == 0) {
+    return NULL;
+  }
+  if (it->list->blockCapacity > 0) {
+    if (it->block == NULL) {
+      return NULL;
+    }
+    return blockSlot(it->list, it->block, it->index);
+  }
+  if (it->current == NULL) {
+    return NULL;
+  }
+  return it->current->data;
+}
+
+void *listIterNext(ListIter *it) {
+  assert(it != NULL);
+  if (it->remaining != UINT64_MAX) {
+    if (it->remaining <= 1) {
+      it->remaining = 0;
+      return NULL;
+    }
+    it->remaining -= 1;
+  }
+
+  if (it->list->blockCapacity > 0) {
+    ListBlock *b = it->block;
+    if (b == NULL) {
+      return NULL;
+    }
+    it->index += 1;
+    if (it->index == b->head + b->count) {
+      it->previousBlock = b;
+      return iterEnterBlock(it, b->next);
+    }
+    return blockSlot(it->list, b, it->index);
+  }
+
+  if (it->current == NULL) {
+    return NULL;
+  }
+  it->previous = it->current;
+  it->current = it->current->next;
+  return it->current == NULL ? NULL : it->current->data;
+}
+
+void *listIterRemove(ListIter *it, void *element) {
+  STATS_COUNT(ST_LIST_REMOVE);
+  assert(it != NULL);
+  List *ls = it->list;
+  if (it->remaining != UINT64_MAX) {
+    it->remaining -= 1;
+  }
+
+  if (ls->blockCapacity > 0) {
+    assert(it->block != NULL);
+    iterRemoveUnrolled(it, element);
+    return listIterGet(it);
+  }
+
+  assert(it->current != NULL);
+  void *data = iterUnlinkNode(it);
+  if (data != NULL) {
+    if (element != NULL) {
+      memcpy(element, data, ls->size);
+    }
+    releaseData(ls, data);
+  }
+  return listIterGet(it);
+}
+
+// Parallel traversal
+
+size_t listSplit(List *ls, ListIter chunks[], size_t nchunks) {
+  assert(ls != NULL);
+  assert(chunks != NULL);
+  if (nchunks > ls->count) {
+    nchunks = (size_t) ls->count;
+  }
+  if (nchunks == 0) {
+    return 0;
+  }
+
+  ListIter it;
+  listIterBegin(&it, ls);
+  uint64_t position = 0;
+  for (size_t c = 0; c < nchunks; c++) {
+    // chunk c covers elements [c * count / nchunks, (c + 1) * count / nchunks)
+    uint64_t start = ls->count * c / nchunks;
+    uint64_t end = ls->count * (c + 1) / nchunks;
+    while (position < start) {
+      listIterNext(&it);
+      position += 1;
+    }
+    chunks[c] = it;
+    chunks[c].remaining = end - start;
+  }
+
+  return nchunks;
+}
+
+typedef struct ListChunkTask {
+  ListIter it;
+  void (*function)(void *, void *);
+  void *arg;
+} ListChunkTask;
+
+static void *runChunk(void *task) {
+  ListChunkTask *t = task;
+  for (void *p = listIterGet(&t->it); p != NULL; p = listIterNext(&t->it)) {
+    t->function(p, t->arg);
+  }
+  return NULL;
+}
+
+void listParallelForEach(List *ls, size_t nthreads, void (*function)(void *, void *), void *arg) {
+  assert(ls != NULL);
+  assert(function != NULL);
+  if (nthreads == 0) {
+    nthreads = 1;
+  }
+
+  ListIter *chunks = calloc(nthreads, sizeof(ListIter));
+  ListChunkTask *tasks = calloc(nthreads, sizeof(ListChunkTask));
+  pthread_t *threads = calloc(nthreads, sizeof(pthread_t));
+  assert(chunks != NULL && tasks != NULL && threads != NULL);
+
+  size_t n = listSplit(ls, chunks, nthreads);
+  for (size_t i = 0; i < n; i++) {
+    tasks[i].it = chunks[i];
+    tasks[i].function = function;
+    tasks[i].arg = arg;
+  }
+
+  // the calling thread takes the first chunk
+  for (size_t i = 1; i < n; i++) {
+    int err = pthread_create(&threads[i], NULL, runChunk, &tasks[i]);
+    assert(err == 0);
+    (void) err;
+  }
+  if (n > 0) {
+    runChunk(&tasks[0]);
+  }
+  for (size_t i = 1; i < n; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  free(chunks);
+  free(tasks);
+  free(threads);
+}
 
 // Initalizes list with desired deinitFunction
 List *initList(deinitFunction deinit, size_t elementSize) {
@@ -15,6 +427,26 @@ List *initList(deinitFunction deinit, size_t elementSize) {
   ls->last = NULL;
   ls->current = NULL;
   ls->previous = NULL;
+  ls->blockCapacity = 0;
+  ls->firstBlock = NULL;
+  ls->lastBlock = NULL;
+  ls->currentBlock = NULL;
+  ls->previousBlock = NULL;
+  ls->currentIndex = 0;
+  ls->pool = NULL;
+
+  return ls;
+}
+
+// Initializes list with elements stored inline in blocks
+List *initUnrolledList(deinitFunction deinit, size_t elementSize, size_t blockCapacity) {
+  assert(elementSize > 0);
+  List *ls = initList(deinit, elementSize);
+
+  if (blockCapacity == 0) {
+    blockCapacity = LIST_BLOCK_BYTES / elementSize;
+  }
+  ls->blockCapacity = blockCapacity > 0 ? blockCapacity : 1;
 
   return ls;
 }
@@ -23,16 +455,28 @@ List *initList(deinitFunction deinit, size_t elementSize) {
 void deinitList(List *ls) {
   assert(ls != NULL);
 
+  if (ls->pool != NULL && ls->deinit == NULL) {
+    // nothing to release per element, the arena reclaims the nodes
+    free(ls);
+    return;
+  }
+
+  ListBlock *b = ls->firstBlock;
+  while (b != NULL) {
+    for (size_t i = b->head; i < b->head + b->count; i++) {
+      releaseElement(ls, blockSlot(ls, b, i));
+    }
+    ListBlock *ptr = b;
+    b = b->next;
+    arena_or_free(ls->pool, ptr, blockBytes(ls));
+  }
+
   ListNode *n = ls->first;
   while (n != NULL) {
-    if (ls->deinit == NULL) {
-      free(n->data);
-    } else {
-      ls->deinit(n->data);
-    }
+    releaseData(ls, n->data);
     ListNode *ptr = n;
     n = n->next;
-    free(ptr);
+    freeNode(ls, ptr);
   }
 
   free(ls);
@@ -41,14 +485,19 @@ void deinitList(List *ls) {
 // Modifiers
 // Inserts element after the last node of the list
 void append(List *ls, void *element) {
+  STATS_COUNT(ST_LIST_INSERT);
   // Preconditions
   assert(ls != NULL);
   assert(element != NULL);
 
+  if (ls->blockCapacity > 0) {
+    unrolledAppend(ls, element);
+    return;
+  }
+
   // initlaize ListNode instance
-  ListNode *n = calloc(1, sizeof(ListNode));
-  assert(n != NULL);
-  n->data = calloc(1, ls->size);
+  ListNode *n = newNode(ls);
+  n->data = newData(ls);
   n->next = NULL;
   assert(n->data != NULL);
 
@@ -67,13 +516,26 @@ void append(List *ls, void *element) {
 }
 
 void __append(List *ls, void *element) {
+  STATS_COUNT(ST_LIST_INSERT);
   // Preconditions
   assert(ls != NULL);
   assert(element != NULL);
 
+  if (ls->blockCapacity > 0) {
+    unrolledAppend(ls, element);
+    free(element);
+    return;
+  }
+
+  if (ls->pool != NULL) {
+    // arena lists only hold arena storage
+    append(ls, element);
+    free(element);
+    return;
+  }
+
   // initlaize ListNode instance
-  ListNode *n = calloc(1, sizeof(ListNode));
-  assert(n != NULL);
+  ListNode *n = newNode(ls);
   n->data = element;
   n->next = NULL;
   assert(n->data != NULL);
@@ -91,14 +553,19 @@ void __append(List *ls, void *element) {
 
 // Insert element before the first node of the list
 void prepend(List *ls, void *element) {
+  STATS_COUNT(ST_LIST_INSERT);
   // Preconditions
   assert(ls != NULL);
   assert(element != NULL);
 
+  if (ls->blockCapacity > 0) {
+    unrolledPrepend(ls, element);
+    return;
+  }
+
   // initlaize ListNode instance
-  ListNode *n = calloc(1, sizeof(ListNode));
-  assert(n != NULL);
-  n->data = calloc(1, ls->size);
+  ListNode *n = newNode(ls);
+  n->data = newData(ls);
   n->next = NULL;
   assert(n->data != NULL);
 
@@ -117,13 +584,26 @@ void prepend(List *ls, void *element) {
 }
 
 void __prepend(List *ls, void *element) {
+  STATS_COUNT(ST_LIST_INSERT);
   // Preconditions
   assert(ls != NULL);
   assert(element != NULL);
 
+  if (ls->blockCapacity > 0) {
+    unrolledPrepend(ls, element);
+    free(element);
+    return;
+  }
+
+  if (ls->pool != NULL) {
+    // arena lists only hold arena storage
+    prepend(ls, element);
+    free(element);
+    return;
+  }
+
   // initlaize ListNode instance
-  ListNode *n = calloc(1, sizeof(ListNode));
-  assert(n != NULL);
+  ListNode *n = newNode(ls);
   n->data = element;
   n->next = NULL;
   assert(n->data != NULL);
@@ -143,15 +623,20 @@ void __prepend(List *ls, void *element) {
 // Removes the first element of the list.
 // Data is copied to the 'data' pointer.
 void removeFirst(List *ls, void *data) {
+  STATS_COUNT(ST_LIST_REMOVE);
   assert(ls != NULL);
   if (isEmpty(ls)) return;
+  if (ls->blockCapacity > 0) {
+    unrolledRemoveFirst(ls, data);
+    return;
+  }
   ListNode *n = ls->first;
   ls->first = ls->first->next;
   if (data != NULL && n->data != NULL) {
     memcpy(data, n->data, ls->size);
-    ls->deinit(n->data);
+    releaseData(ls, n->data);
   }
-  free(n);
+  freeNode(ls, n);
   ls->count -= 1;
 }
 
@@ -160,22 +645,36 @@ void removeFirst(List *ls, void *data) {
 void removeLast(List *ls, void *data) {
   assert(ls != NULL);
   if (isEmpty(ls)) return;
-  if (ls->first == ls->last) {
-    // List has a single element
+  if (ls->first == ls->last && ls->blockCapacity == 0) {
+    // List has a single element, counted by removeFirst()
     removeFirst(ls, data);
     ls->last = NULL;
     return;
   }
+  STATS_COUNT(ST_LIST_REMOVE);
+  if (ls->blockCapacity > 0) {
+    unrolledRemoveLast(ls, data);
+    return;
+  }
 
   ListNode *n = ls->last;
 
-  ListNode *ptr = ls->previous;
+  // nodes are singly linked, find the predecessor of the last node
+  ListNode *ptr = ls->first;
+  while (ptr->next != n) {
+    ptr = ptr->next;
+  }
+  ptr->next = NULL;
+  ls->last = ptr;
+  if (ls->current == n) {
+    ls->current = NULL;
+  }
 
   if (data != NULL && n->data != NULL) {
     memcpy(data, n->data, ls->size);
-    ls->deinit(n->data);
+    releaseData(ls, n->data);
   }
-  free(n);
+  freeNode(ls, n);
   ls->count -= 1;
 }
 
@@ -192,6 +691,10 @@ bool isEmpty(List *ls) {
 
 void *getFirstRef(List *ls) {
   assert(ls != NULL);
+  if (ls->blockCapacity > 0) {
+    ListBlock *b = ls->firstBlock;
+    return b == NULL ? NULL : blockSlot(ls, b, b->head);
+  }
   if (ls->first == NULL) {
     return NULL;
   } else {
@@ -201,6 +704,10 @@ void *getFirstRef(List *ls) {
 
 void *getLastRef(List *ls) {
   assert(ls != NULL);
+  if (ls->blockCapacity > 0) {
+    ListBlock *b = ls->lastBlock;
+    return b == NULL ? NULL : blockSlot(ls, b, b->head + b->count - 1);
+  }
   if (ls->last == NULL) {
     return NULL;
   } else {
@@ -209,109 +716,66 @@ void *getLastRef(List *ls) {
 }
 
 // Iterators
+// The list's own cursor is a ListIter kept in the list fields
+
+static inline ListIter loadCursor(List *ls) {
+  ListIter it;
+  it.list = ls;
+  it.current = ls->current;
+  it.previous = ls->previous;
+  it.block = ls->currentBlock;
+  it.previousBlock = ls->previousBlock;
+  it.index = ls->currentIndex;
+  it.remaining = UINT64_MAX;
+  return it;
+}
+
+static inline void storeCursor(List *ls, ListIter *it) {
+  ls->current = it->current;
+  ls->previous = it->previous;
+  ls->currentBlock = it->block;
+  ls->previousBlock = it->previousBlock;
+  ls->currentIndex = it->index;
+}
+
 void *resetIteration(List *ls) {
   assert(ls != NULL);
-  ls->current = ls->first;
-  ls->previous = NULL;
-  if (ls->current == NULL) {
-    return NULL;
-  }
-  return ls->current->data;
+  ListIter it;
+  void *ref = listIterBegin(&it, ls);
+  storeCursor(ls, &it);
+  return ref;
 }
 
 void *getCurrentRef(List *ls) {
   assert(ls != NULL);
-  if (ls->current == NULL) {
-    return NULL;
-  } else {
-    return ls->current->data;
-  }
+  ListIter it = loadCursor(ls);
+  return listIterGet(&it);
 }
 
 void removeCurrent(List *ls, void *element) {
   assert(ls != NULL);
-  assert(ls->current != NULL);
-
   if (isEmpty(ls)) return;
-
-  ListNode *n = ls->current;
-
-  if (ls->current == ls->first) {
-    // remove head of the list
-    ls->first = ls->first->next;
-    ls->current = ls->first;
-  } else if (ls->current == ls->last) {
-    ls->last = ls->previous;
-    if (ls->previous != NULL) {
-      // maybe not needed
-      ls->previous->next = NULL;
-    }
-    ls->current = NULL;
-  } else {
-    ls->previous->next = ls->current->next;
-    ls->current = ls->current->next;
-
-  }
-
-  if (element != NULL && n->data != NULL) {
-    memcpy(element, n->data, ls->size);
-  }
-
-  if (n->data != NULL) {
-    ls->deinit(n->data);
-  }
-
-  free(n);
-  ls->count -= 1;
+  ListIter it = loadCursor(ls);
+  listIterRemove(&it, element);
+  storeCursor(ls, &it);
 }
 
 void *__removeCurrent(List *ls) {
+  STATS_COUNT(ST_LIST_REMOVE);
   assert(ls != NULL);
-  assert(ls->current != NULL);
-
   if (isEmpty(ls)) return NULL;
-
-  ListNode *n = ls->current;
-  void *data = n->data;
-  if (ls->current == ls->first) {
-    // remove head of the list
-    ls->first = ls->first->next;
-    ls->current = ls->first;
-  } else if (ls->current == ls->last) {
-    ls->last = ls->previous;
-    if (ls->previous != NULL) {
-      // maybe not needed
-      ls->previous->next = NULL;
-    }
-    ls->current = NULL;
-  } else {
-    // ListNode *ptr = ls->previous;
-    // ptr->next = ls->current->next;
-    // ls->current = ls->current->next;
-
-    ls->previous->next = ls->current->next;
-    ls->current = ls->current->next;
-  }
-
-  free(n);
-  ls->count -= 1;
-
+  ListIter it = loadCursor(ls);
+  void *data = iterTake(&it);
+  storeCursor(ls, &it);
   return data;
 }
 
 void *getNextRef(List *ls) {
   assert(ls != NULL);
-  if (ls->current == NULL) {
-    return NULL;
-  } else {
-    ls->previous = ls->current;
-    ls->current = ls->current->next;
-    if (ls->current != NULL) {
-      return ls->current->data;
-    } else {
-      return NULL;
-    }
-  }
+  ListIter it = loadCursor(ls);
+  void *ref = listIterNext(&it);
+  storeCursor(ls, &it);
+  return ref;
 }
 
 void forEach(List *ls, void (*function)(void *)) {
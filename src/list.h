@@ -2,6 +2,10 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include "arena.h"
+
+// Default payload size of an unrolled list block
+#define LIST_BLOCK_BYTES 1024
 
 typedef void (*deinitFunction)(void *);
 
@@ -10,6 +14,34 @@ typedef struct ListNode {
   struct ListNode *next;
 } ListNode;
 
+// Node of an unrolled list: holds up to List.blockCapacity elements inline.
+// Live elements occupy slots [head, head + count).
+typedef struct ListBlock {
+  struct ListBlock *next;
+  size_t head;
+  size_t count;
+  unsigned char data[];
+} ListBlock;
+
+struct List;
+
+// Cursor over a List, independent from the list's own iteration state.
+// Any number of iterators may read a list at once as long as nobody
+// modifies it.
+typedef struct ListIter {
+  // Iterated list
+  struct List *list;
+  // Current and previous nodes of a node-per-element list
+  ListNode *current;
+  ListNode *previous;
+  // Current and previous blocks and the element index of an unrolled list
+  ListBlock *block;
+  ListBlock *previousBlock;
+  size_t index;
+  // Elements left in the iterated range, UINT64_MAX to run to the end
+  uint64_t remaining;
+} ListIter;
+
 typedef struct List {
   // Number of elements on the list
   uint64_t count;
@@ -27,22 +59,44 @@ typedef struct List {
   // Pointer to 'previous' node
   ListNode *previous;
 
+  // Elements per block on unrolled lists, 0 on node-per-element lists
+  size_t blockCapacity;
+  // First and last blocks of an unrolled list
+  ListBlock *firstBlock;
+  ListBlock *lastBlock;
+  // Iteration cursor of an unrolled list
+  ListBlock *currentBlock;
+  ListBlock *previousBlock;
+  size_t currentIndex;
+
+  // Optional arena for nodes, blocks and element copies, NULL to use the
+  // system allocator. Set it right after initialization. Elements are then
+  // copied into the arena, so deinit must not free the element itself.
+  arena *pool;
+
 } List;
 
 // Initalizes list
 // deinitFunction: Function to be called whenever some element is removed or the list is deinitialized.
 // elementSize: Size of the stored data element.
 List *initList(deinitFunction deinit, size_t elementSize);
+// Initializes an unrolled list, storing up to blockCapacity elements inline
+// in each node. Elements are copied into the blocks, so deinit must only
+// release resources owned by an element and never the element itself.
+// blockCapacity: 0 picks a block of roughly LIST_BLOCK_BYTES.
+List *initUnrolledList(deinitFunction deinit, size_t elementSize, size_t blockCapacity);
 // Frees up the list and all its elements
 void deinitList(List *ls);
 
 // Modifiers
 // Inserts element after the last node of the list
 void append(List *ls, void *element);
+// On unrolled lists the element is copied and then released with free()
 void __append(List *ls, void *element);
 
 // Insert element before the first node of the list
 void prepend(List *ls, void *element);
+// Takes ownership of element, as __append does
 void __prepend(List *ls, void *element);
 
 // Removes the first element of the list.
@@ -62,8 +116,30 @@ void *getLastRef(List *ls);
 void *resetIteration(List *ls);
 void *getCurrentRef(List *ls);
 void removeCurrent(List *ls, void *element);
+// Returns the removed element, to be released by the caller.
+// On unrolled lists this is a heap copy of the element.
 void *__removeCurrent(List *ls);
 void *getNextRef(List *ls);
 
 void forEach(List *ls, void (*function)(void *));
 
+// Detached iterators
+// Positions it on the first element of ls and returns it
+void *listIterBegin(ListIter *it, List *ls);
+// Returns the element under it, NULL past the end
+void *listIterGet(ListIter *it);
+// Advances it and returns the new element, NULL past the end
+void *listIterNext(ListIter *it);
+// Removes the element under it, as removeCurrent() does, and returns the
+// element that follows. Must not run while other iterators are in use.
+void *listIterRemove(ListIter *it, void *element);
+
+// Parallel traversal
+// Splits ls into at most nchunks ranges of nearly equal length. chunks[i]
+// is positioned at the start of range i and stops at its end.
+// Returns the number of ranges.
+size_t listSplit(List *ls, ListIter chunks[], size_t nchunks);
+// Calls function(element, arg) on every element of ls from nthreads
+// threads. ls must not be modified meanwhile.
+void listParallelForEach(List *ls, size_t nthreads, void (*function)(void *, void *), void *arg);
+
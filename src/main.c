@@ -4,9 +4,21 @@
 #include <math.h>
 #include <ctype.h>
 #include <float.h>
+#include <unistd.h>
 #include "graph.h"
 #include "priority_queue.h"
 #include "hash_table.h"
+#include "landmarks.h"
+#include "ch.h"
+#include "graph_io.h"
+#include "reorder.h"
+#include "serve.h"
+#include "sssp_cache.h"
+#include "components.h"
+#include "estimate.h"
+#include "compact.h"
+#include "packed.h"
+#include "stats.h"
 
 #define DBL_EQ(x, y) (fabs(x - y) <= DBL_EPSILON)
 #define OPPOS 2 // operation position
@@ -15,20 +27,59 @@
 #define MST 1   // mst operation index
 #define DIST 2  // distribution operation index
 #define TEST 3  // test operation index
-
-// Counts the number of lines in file f.
-size_t lines(FILE *f);
-
-// Reads graph from file at 'filename'.
-// Stops program's execution if anything goes wrong.
-graph *read_graph(const char *restrict filename, graph *g);
-
-// Prints path between a and b with distance do fp
-// dists and prev are output of dijkstra
-void path(size_t nvertices, size_t a, size_t b,
-    double dists[], int prev[], FILE *fp);
+#define SERVE 4 // serve operation index
+
+// Options given as --name or --name=value anywhere on the command line
+typedef struct options {
+  // algorithm used by the distribution operation
+  dd_engine engine;
+  // threads for parallel algorithms
+  size_t threads;
+  // landmarks for A* path queries, 0 to run dijkstra
+  size_t landmarks;
+  // whether serve answers path queries with a contraction hierarchy
+  bool ch;
+  // vertex order the graph is relabeled to after reading
+  vertex_order order;
+  // whether to drop parallel edges and self-loops after reading
+  bool dedup;
+  // whether to store edges with 32-bit ids and narrow weights
+  bool compact;
+  // whether to store edges as compressed sorted gaps
+  bool packed;
+  // whether to print timers and counters as JSON on stderr at exit
+  bool stats;
+  // whether path a . prints the shortest path tree instead of every path
+  bool tree;
+  // whether output files are written through a shared mapping
+  bool mmap;
+  // memory budget of the shortest path tree cache
+  size_t cache_bytes;
+  // directory shortest path trees are spilled to, NULL for none
+  const char *spill_dir;
+  // sources sampled by an approximate distribution, all zero for exact
+  dd_sampling sampling;
+} options;
+
+// Reads the flags in argv into opts and removes them from argv.
+// Returns the number of remaining arguments.
+int parse_options(int argc, const char *argv[], options *opts);
+
+// Starts w on the file at filename, or on stdout if filename is NULL.
+// Returns false if the file cannot be opened.
+bool open_output(const char *filename, const options *opts, writer *w);
+
+// Reads the graph at filename and prepares it as opts ask
+graph *open_graph(const char *filename, const options *opts);
+
+// Loads the k landmarks of g stored next to its file into lm,
+// computing and storing them if they are missing or stale.
+void load_landmarks(graph *g, const char *filename, size_t k, landmarks *lm);
 
 int main(int argc, const char *argv[]) {
+  options opts;
+  argc = parse_options(argc, argv, &opts);
+
   if (argc < 3) {
     printf("No arguments supplied.\nUsage: %s filename operation [arguments]\n", argv[0]);
     exit(EXIT_FAILURE);
@@ -36,7 +87,7 @@ int main(int argc, const char *argv[]) {
 
   const char *filename = argv[FPOS];
 
-  const char *operations[] = {"path", "mst", "distribution", "test"};
+  const char *operations[] = {"path", "mst", "distribution", "test", "serve"};
 
   // Carry out operation.
   if (strncmp(argv[OPPOS], operations[PATH], strlen(operations[PATH])) == 0) {
@@ -45,7 +96,7 @@ int main(int argc, const char *argv[]) {
       exit(EXIT_FAILURE);
     }
 
-    graph *g = read_graph(filename, calloc(1, sizeof(graph)));
+    graph *g = open_graph(filename, &opts);
 
     // indicates whether to calculate distance between a and all other points
     bool all = (argv[OPPOS + 2][0] == '.');
@@ -58,26 +109,33 @@ int main(int argc, const char *argv[]) {
       exit(EXIT_FAILURE);
     }
 
-    FILE *fp = stdout;
-    if (argc > 5) {
-      const char *output_filename = argv[5];
-      fp = fopen(output_filename, "w");
-      if (!fp) {
-        printf("Could not open file '%s' for writing. Exiting.\n", output_filename);
-        exit(EXIT_FAILURE);
-      }
+    const char *output_filename = argc > 5 ? argv[5] : NULL;
+    writer w;
+    if (!open_output(output_filename, &opts, &w)) {
+      printf("Could not open file '%s' for writing. Exiting.\n", output_filename);
+      exit(EXIT_FAILURE);
     }
 
     double *dists = calloc(g->nvertices, sizeof(double));
     int *prev = calloc(g->nvertices, sizeof(int));
 
-    // calculate distances and paths
-    dijkstra(g, (size_t) a, dists, prev);
-
-    if (fp != stdout) {
+    if (output_filename) {
       printf("Writing to file.\n");
     }
 
+    // trees spilled by earlier runs answer repeated sources
+    sssp_cache cache;
+    sssp_cache *c = opts.spill_dir ? sssp_cache_init(&cache, opts.cache_bytes, opts.spill_dir) : NULL;
+    uint64_t fingerprint = c ? graph_fingerprint(g) : 0;
+    sssp_entry *e = NULL;
+
+    // searches stay inside the source's component
+    STATS_BEGIN(SP_PREPARE);
+    components cc;
+    find_components(g, &cc, g->nthreads);
+    priority_queue *pq = pq_init(calloc(1, sizeof(priority_queue)), g->nvertices + 1);
+    STATS_END(SP_PREPARE);
+
     if (!all) {
       // determine endpoint b
       int b = atoi(argv[OPPOS + 2]) - 1;
@@ -85,27 +143,78 @@ int main(int argc, const char *argv[]) {
         printf("Invalid vertex '%s'. Exiting\n", argv[OPPOS + 2]);
         exit(EXIT_FAILURE);
       }
+
+      size_t s = graph_vertex(g, (size_t) a);
+      size_t t = graph_vertex(g, (size_t) b);
+      STATS_BEGIN(SP_COMPUTE);
+      if (cc.id[s] != cc.id[t]) {
+        // no path, nothing to search
+        dists[t] = INF;
+        prev[t] = -1;
+      } else if (c && (e = sssp_cache_find(c, fingerprint, s, g->nvertices))) {
+        // answered by a spilled tree
+      } else if (opts.landmarks > 0 && !g->directed) {
+        // A* guided by landmark distances stored next to the graph
+        landmarks lm;
+        load_landmarks(g, filename, opts.landmarks, &lm);
+        astar(g, &lm, s, t, dists, prev);
+        lm_destroy(&lm);
+      } else if (c) {
+        e = sssp_cache_get(c, g, fingerprint, s, NULL);
+      } else {
+        shortest_paths_within(g, &cc, s, dists, prev, pq);
+      }
+      STATS_END(SP_COMPUTE);
+
       // path and distance between a and b
-      path(g->nvertices, (size_t) a, (size_t) b, dists, prev, fp);
+      STATS_BEGIN(SP_OUTPUT);
+      path(g, s, t, e ? e->dist : dists, e ? e->prev : prev, &w);
+      STATS_END(SP_OUTPUT);
     } else {
       // calculate distances and paths
-      dijkstra(g, (size_t) a, dists, prev);
-
-      // print all paths and distances
-      for (size_t i = 0; i < g->nvertices; i++) {
-        if ((int) i == a) continue;
-        // print path
-        path(g->nvertices, (size_t) a, (size_t) i, dists, prev, fp);
+      size_t s = graph_vertex(g, (size_t) a);
+      STATS_BEGIN(SP_COMPUTE);
+      if (c) {
+        e = sssp_cache_get(c, g, fingerprint, s, NULL);
+      } else {
+        shortest_paths_within(g, &cc, s, dists, prev, pq);
+      }
+      STATS_END(SP_COMPUTE);
+
+      // print the tree once, or all paths and distances, by original id
+      STATS_BEGIN(SP_OUTPUT);
+      if (opts.tree) {
+        print_tree(g, s, e ? e->dist : dists, e ? e->prev : prev, &w);
+      } else {
+        for (size_t i = 0; i < g->nvertices; i++) {
+          if ((int) i == a) continue;
+          // print path
+          path(g, s, graph_vertex(g, i), e ? e->dist : dists, e ? e->prev : prev, &w);
+        }
       }
+      STATS_END(SP_OUTPUT);
+    }
+
+    if (c) {
+      sssp_cache_destroy(c);
     }
 
-    if (fp != stdout) {
-      fclose(fp);
+    STATS_BEGIN(SP_OUTPUT);
+    bool written = writer_close(&w);
+    STATS_END(SP_OUTPUT);
+    if (!written) {
+      printf("Could not write results. Exiting.\n");
+      exit(EXIT_FAILURE);
+    }
+    if (output_filename) {
       printf("Done.\n");
     }
 
     free(dists);
     free(prev);
+    pq_destroy(pq);
+    free(pq);
+    components_destroy(&cc);
     destroy_graph(g);
     free(g);
   } else if (strncmp(argv[OPPOS], operations[MST], strlen(operations[MST])) == 0) {
@@ -114,184 +223,369 @@ int main(int argc, const char *argv[]) {
       exit(EXIT_FAILURE);
     }
 
-    graph *g = read_graph(filename, calloc(1, sizeof(graph)));
+    graph *g = open_graph(filename, &opts);
 
     int *parents = calloc(g->nvertices, sizeof(int));
     double *keys = calloc(g->nvertices, sizeof(double));
 
-    prim(g, parents, keys);
+    // one tree per component
+    STATS_BEGIN(SP_PREPARE);
+    components cc;
+    find_components(g, &cc, g->nthreads);
+    priority_queue *pq = pq_init(calloc(1, sizeof(priority_queue)), g->nvertices + 1);
+    STATS_END(SP_PREPARE);
+    STATS_BEGIN(SP_COMPUTE);
+    spanning_forest(g, &cc, parents, keys, pq);
+    STATS_END(SP_COMPUTE);
+    pq_destroy(pq);
+    free(pq);
 
     // determine where to print output (stdout or file)
-    FILE *fp = stdout;
-    if (argc > 3) {
-      fp = fopen(argv[3], "w");
-      if (!fp) {
-        printf("Could not open file '%s' for writing. Exiting.\n", argv[3]);
-        exit(EXIT_FAILURE);
-      }
-
+    const char *output_filename = argc > 3 ? argv[3] : NULL;
+    writer w;
+    if (!open_output(output_filename, &opts, &w)) {
+      printf("Could not open file '%s' for writing. Exiting.\n", output_filename);
+      exit(EXIT_FAILURE);
     }
 
-    if (fp != stdout) {
+    if (output_filename) {
       printf("Writing mst to file.\n");
     }
 
-    fprintf(fp, "%zu\n", g->nvertices);
-
-    double total_cost = 0.0;
-    for (size_t i = 0; i < g->nvertices; i++) {
-      if (parents[i] == -1) continue;
-      total_cost += keys[i];
-      fprintf(fp, "%zu %d %f\n", i + 1, parents[i] + 1, keys[i]);
+    STATS_BEGIN(SP_OUTPUT);
+    print_mst(g, &cc, parents, keys, &w);
+    bool written = writer_close(&w);
+    STATS_END(SP_OUTPUT);
+    if (!written) {
+      printf("Could not write results. Exiting.\n");
+      exit(EXIT_FAILURE);
     }
 
-    fprintf(fp, "Total cost: %f\n", total_cost);
-
     // done printing
-    if (fp != stdout) {
-      fclose(fp);
+    if (output_filename) {
       printf("Done.\n");
     }
 
     // clean up
+    components_destroy(&cc);
     destroy_graph(g);
     free(parents);
+    free(keys);
     free(g);
   } else if (strncmp(argv[OPPOS], operations[DIST], strlen(operations[DIST])) == 0) {
 
     // determine where to print output (file of stdout)
 
-    FILE *fp = stdout;
+    const char *output_filename = argc > 3 ? argv[OPPOS + 1] : NULL;
+    writer w;
+    if (!open_output(output_filename, &opts, &w)) {
+      printf("Could not open file '%s' for writing. Exiting.\n", output_filename);
+      exit(EXIT_FAILURE);
+    }
 
-    if (argc > 3) {
-      const char *output_filename = argv[OPPOS + 1];
-      fp = fopen(output_filename, "w");
-      if (!fp) {
-        printf("Could not open file '%s' for writing. Exiting.\n", output_filename);
-        exit(EXIT_FAILURE);
+    graph *g = open_graph(filename, &opts);
+    if (opts.sampling.samples || opts.sampling.error > 0) {
+      // estimate from a sample of sources
+      dd_estimate est;
+      STATS_BEGIN(SP_COMPUTE);
+      estimate_distribution(g, &est, &opts.sampling);
+      STATS_END(SP_COMPUTE);
+      if (output_filename) {
+        printf("Writing to file.\n");
       }
+      STATS_BEGIN(SP_OUTPUT);
+      print_estimate(g, &est, &w);
+      STATS_END(SP_OUTPUT);
+      estimate_destroy(&est);
+    } else {
+      hash_table *ht = calloc(1, sizeof(hash_table));
+      STATS_BEGIN(SP_COMPUTE);
+      distance_distribution_engine(g, ht, opts.engine);
+      STATS_END(SP_COMPUTE);
+
+      // Print results
+      if (output_filename) {
+        printf("Writing to file.\n");
+      }
+      STATS_BEGIN(SP_OUTPUT);
+      print_distribution(g, ht, &w);
+      STATS_END(SP_OUTPUT);
+      ht_destroy(ht);
+      free(ht);
     }
 
-    graph *g = read_graph(filename, calloc(1, sizeof(graph)));
-    hash_table *ht = calloc(1, sizeof(hash_table));
-    distance_distribution(g, ht);
+    // Done printing
+    STATS_BEGIN(SP_OUTPUT);
+    bool written = writer_close(&w);
+    STATS_END(SP_OUTPUT);
+    if (!written) {
+      printf("Could not write results. Exiting.\n");
+      exit(EXIT_FAILURE);
+    }
+    if (output_filename) {
+      printf("Done\n");
+    }
 
-    // get data on a easier to iterate on format
-    double *dists = calloc(ht->count, sizeof(double));
-    size_t *counts = calloc(ht->count, sizeof(size_t));
-    ht_arrays(ht, (uint8_t *) dists, (uint8_t *) counts);
+    // Clean up
+    destroy_graph(g);
+    free(g);
+  } else if (strncmp(argv[OPPOS], operations[SERVE], strlen(operations[SERVE])) == 0) {
+    graph *g = open_graph(filename, &opts);
 
-    // Print results
+    landmarks lm;
+    bool use_lm = opts.landmarks > 0 && !g->directed;
+    if (use_lm) {
+      load_landmarks(g, filename, opts.landmarks, &lm);
+    }
 
-    fprintf(fp, "Distance distribution:\n");
+    contraction_hierarchy ch;
+    bool use_ch = false;
+    if (opts.ch) {
+      const char *reason = NULL;
+      use_ch = ch_suitable(g, &reason);
+      if (use_ch) {
+        STATS_BEGIN(SP_PREPARE);
+        ch_build(&ch, g);
+        STATS_END(SP_PREPARE);
+      } else {
+        fprintf(stderr, "Contraction hierarchy not built: %s.\n", reason);
+      }
+    }
 
-    // total possible unordered vertex pairs
-    double total = (double) g->nvertices * ((double) g->nvertices - 1.0) / 2.0;
+    server s;
+    server_init(&s, g, use_lm ? &lm : NULL, use_ch ? &ch : NULL, opts.engine,
+        opts.cache_bytes, opts.spill_dir);
 
-    // Begin printing
-    if (fp != stdout) {
-      printf("Writing to file.\n");
+    if (argc > 3) {
+      // clients connect to a Unix socket
+      if (!server_listen(&s, argv[OPPOS + 1])) {
+        printf("Could not listen on socket '%s'. Exiting.\n", argv[OPPOS + 1]);
+        exit(EXIT_FAILURE);
+      }
+    } else {
+      static char buffer[SERVE_BUFFER];
+      setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+      server_session(&s, STDIN_FILENO, stdout);
     }
 
-    for (size_t i = 0; i < ht->count; i++) {
-      double frac = (double) counts[i]/ total;
-      fprintf(fp, "%f: %f\n", dists[i], frac);
+    server_destroy(&s);
+    if (use_lm) {
+      lm_destroy(&lm);
     }
-
-    // Done printing
-    if (fp != stdout) {
-      printf("Done\n");
-      fclose(fp);
+    if (use_ch) {
+      ch_destroy(&ch);
     }
-
-    // Clean up
-    free(dists);
-    free(counts);
-    ht_destroy(ht);
-    free(ht);
     destroy_graph(g);
     free(g);
   } else {
     printf("Invalid option '%s'\n", argv[OPPOS]);
   }
 
+  if (opts.stats) {
+    stats_print(stderr);
+  }
+
   return 0;
 }
 
-size_t lines(FILE *f) {
-  size_t lines = 0;
-  while(!feof(f)) {
-    int ch = fgetc(f);
-    if(ch == '\n') {
-      lines++;
+int parse_options(int argc, const char *argv[], options *opts) {
+  opts->engine = DD_AUTO;
+  opts->threads = 1;
+  opts->landmarks = 0;
+  opts->ch = false;
+  opts->order = ORDER_NONE;
+  opts->dedup = false;
+  opts->compact = false;
+  opts->packed = false;
+  opts->stats = false;
+  opts->tree = false;
+  opts->mmap = false;
+  opts->cache_bytes = SSSP_CACHE_DEFAULT_BYTES;
+  opts->spill_dir = NULL;
+  opts->sampling = (dd_sampling) {0, 0.0, ESTIMATE_DEFAULT_SEED};
+
+  int n = 0;
+  for (int i = 0; i < argc; i++) {
+    const char *arg = argv[i];
+    if (strncmp(arg, "--", 2) != 0) {
+      // positional argument, keep it
+      argv[n++] = arg;
+      continue;
     }
-  }
-  rewind(f);
-  return lines;
-}
 
-graph *read_graph(const char *restrict filename, graph *g) {
-  assert(g);
+    if (strncmp(arg, "--engine=", 9) == 0) {
+      const char *engine = arg + 9;
+      if (strcmp(engine, "dijkstra") == 0) {
+        opts->engine = DD_DIJKSTRA;
+      } else if (strcmp(engine, "batch") == 0) {
+        opts->engine = DD_BATCH;
+      } else if (strcmp(engine, "floyd") == 0) {
+        opts->engine = DD_FLOYD;
+      } else {
+        printf("Invalid engine '%s'. Exiting.\n", engine);
+        exit(EXIT_FAILURE);
+      }
+    } else if (strncmp(arg, "--threads=", 10) == 0) {
+      int threads = atoi(arg + 10);
+      if (threads <= 0) {
+        printf("Invalid thread count '%s'. Exiting.\n", arg + 10);
+        exit(EXIT_FAILURE);
+      }
+      opts->threads = (size_t) threads;
+    } else if (strcmp(arg, "--alt") == 0) {
+      opts->landmarks = LM_DEFAULT_COUNT;
+    } else if (strncmp(arg, "--alt=", 6) == 0) {
+      int k = atoi(arg + 6);
+      if (k <= 0) {
+        printf("Invalid landmark count '%s'. Exiting.\n", arg + 6);
+        exit(EXIT_FAILURE);
+      }
+      opts->landmarks = (size_t) k;
+    } else if (strcmp(arg, "--ch") == 0) {
+      opts->ch = true;
+    } else if (strncmp(arg, "--cache=", 8) == 0) {
+      char *end;
+      double mib = strtod(arg + 8, &end);
+      if (end == arg + 8 || *end != '\0' || mib < 0) {
+        printf("Invalid cache size '%s'. Exiting.\n", arg + 8);
+        exit(EXIT_FAILURE);
+      }
+      opts->cache_bytes = (size_t) (mib * (1 << 20));
+    } else if (strncmp(arg, "--spill=", 8) == 0) {
+      opts->spill_dir = arg + 8;
+    } else if (strncmp(arg, "--samples=", 10) == 0) {
+      int samples = atoi(arg + 10);
+      if (samples <= 0) {
+        printf("Invalid sample count '%s'. Exiting.\n", arg + 10);
+        exit(EXIT_FAILURE);
+      }
+      opts->sampling.samples = (size_t) samples;
+    } else if (strncmp(arg, "--error=", 8) == 0) {
+      char *end;
+      double error = strtod(arg + 8, &end);
+      if (end == arg + 8 || *end != '\0' || error <= 0) {
+        printf("Invalid error target '%s'. Exiting.\n", arg + 8);
+        exit(EXIT_FAILURE);
+      }
+      opts->sampling.error = error;
+    } else if (strncmp(arg, "--seed=", 7) == 0) {
+      opts->sampling.seed = strtoull(arg + 7, NULL, 10);
+    } else if (strcmp(arg, "--dedup") == 0) {
+      opts->dedup = true;
+    } else if (strcmp(arg, "--compact") == 0) {
+      opts->compact = true;
+    } else if (strcmp(arg, "--packed") == 0) {
+      opts->packed = true;
+    } else if (strcmp(arg, "--stats") == 0) {
+      opts->stats = true;
+    } else if (strcmp(arg, "--tree") == 0) {
+      opts->tree = true;
+    } else if (strcmp(arg, "--mmap") == 0) {
+      opts->mmap = true;
+    } else if (strncmp(arg, "--order=", 8) == 0) {
+      const char *order = arg + 8;
+      if (strcmp(order, "none") == 0) {
+        opts->order = ORDER_NONE;
+      } else if (strcmp(order, "rcm") == 0) {
+        opts->order = ORDER_RCM;
+      } else if (strcmp(order, "degree") == 0) {
+        opts->order = ORDER_DEGREE;
+      } else if (strcmp(order, "bfs") == 0) {
+        opts->order = ORDER_BFS;
+      } else {
+        printf("Invalid order '%s'. Exiting.\n", order);
+        exit(EXIT_FAILURE);
+      }
+    } else {
+      printf("Invalid option '%s'. Exiting.\n", arg);
+      exit(EXIT_FAILURE);
+    }
+  }
 
-  FILE *f = fopen(filename, "r");
-  if (!f) {
-    printf("Error: could not read file '%s'. Exiting.\n", filename);
+  if ((opts->compact || opts->packed) && opts->landmarks > 0) {
+    printf("A* search does not run on compact graphs. Exiting.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (opts->compact && opts->packed) {
+    printf("Choose one of --compact and --packed. Exiting.\n");
     exit(EXIT_FAILURE);
   }
 
-  size_t nedges = lines(f) - 1;
+  return n;
+}
 
-  int nvertices;
+bool open_output(const char *filename, const options *opts, writer *w) {
+  if (!filename) {
+    // anything printf() buffered must come first
+    fflush(stdout);
+    writer_fd(w, STDOUT_FILENO);
+    return true;
+  }
+  if (opts->mmap) {
+    return writer_mmap(w, filename);
+  }
+  return writer_file(w, filename);
+}
 
-  fscanf(f, "%d", &nvertices);
+graph *open_graph(const char *filename, const options *opts) {
+  STATS_BEGIN(SP_LOAD);
+  graph *g = load_graph(filename, calloc(1, sizeof(graph)), opts->threads);
+  g->nthreads = opts->threads;
+  STATS_END(SP_LOAD);
 
-  if (nvertices <= 0) {
-    printf("Invalid vertex count '%d'. Exiting.\n", nvertices);
-    exit(EXIT_FAILURE);
-  }
+  STATS_BEGIN(SP_PREPARE);
 
-  init_graph(g, (size_t) nvertices, nedges, false);
+  if (opts->dedup) {
+    canon_stats removed;
+    size_t before = g->nedges;
+    canonicalize_graph(g, &removed);
+    fprintf(stderr, "Removed %zu parallel edges and %zu self-loops (%zu of %zu adjacency entries left).\n",
+        removed.parallel, removed.loops, g->nedges, before);
+  }
 
-  for (size_t i = 0; i < nedges; i++) {
-    int x, y;
-    double w;
-    fscanf(f, "%d %d %lf", &x, &y, &w);
-    // assumes 1 indexing of vertices and positive weights
-    // check if values are inside bounds
-    if (x <= 0) {
-      printf("Error processing edge (%d, %d, %f). Invalid point '%d'. Exiting.\n", x, y, w, x);
-      exit(EXIT_FAILURE);
-    }
+  reorder_graph(g, opts->order);
 
-    if (y <= 0) {
-      printf("Error processing edge (%d, %d, %f). Invalid point '%d'. Exiting.\n", x, y, w, y);
+  if (opts->compact) {
+    const char *reason = NULL;
+    size_t before = graph_edge_bytes(g);
+    if (!compact_graph(g, &reason)) {
+      printf("Cannot store the graph compactly: %s. Exiting.\n", reason);
       exit(EXIT_FAILURE);
     }
+    fprintf(stderr, "Compact edges take %zu bytes instead of %zu.\n", graph_edge_bytes(g), before);
+  }
 
-    if (w < 0.0) {
-      printf("Error processing edge (%d, %d, %f). Invalid weight '%f'. Exiting.\n", x, y, w, w);
+  if (opts->packed) {
+    const char *reason = NULL;
+    size_t before = graph_edge_bytes(g);
+    if (!packed_graph(g, &reason)) {
+      printf("Cannot store the graph compactly: %s. Exiting.\n", reason);
       exit(EXIT_FAILURE);
     }
-
-    insert_edge(g, (size_t) x-1, (size_t) y-1, w, false); // -1 (0 index for storage)
+    fprintf(stderr, "Packed edges take %zu bytes instead of %zu.\n", graph_edge_bytes(g), before);
   }
-
-  fclose(f);
-
+  STATS_END(SP_PREPARE);
   return g;
 }
 
-void path(size_t nvertices, size_t a, size_t b,
-  double dists[], int prev[], FILE *fp) {
-  assert(a < nvertices);
-  assert(b < nvertices);
-  fprintf(fp, "d(%zu, %zu) = %f, [", a + 1, b + 1, dists[b]);
+void load_landmarks(graph *g, const char *filename, size_t k, landmarks *lm) {
+  char *lm_filename = calloc(strlen(filename) + strlen(LM_FILE_SUFFIX) + 1, 1);
+  assert(lm_filename);
+  strcat(strcpy(lm_filename, filename), LM_FILE_SUFFIX);
 
-  int curr = (int) b;
-  while (curr >= 0 && curr != (int) a) {
-    fprintf(fp, "%d, ", curr + 1);
-    curr = prev[curr];
+  bool loaded = lm_load(lm, lm_filename, g);
+  if (loaded && lm->k != k && lm->k != g->nvertices) {
+    // stored with another landmark count
+    lm_destroy(lm);
+    loaded = false;
+  }
+
+  if (!loaded) {
+    lm_build(lm, g, k);
+    if (!lm_save(lm, lm_filename)) {
+      printf("Warning: could not write landmarks to '%s'.\n", lm_filename);
+    }
   }
-  fprintf(fp, "%zu]\n", a + 1);
-}
 
+  free(lm_filename);
+}
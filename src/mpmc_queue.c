@@ -0,0 +1,278 @@
+#include "mpmc_queue.h"
+#include <string.h>
+#include <assert.h>
+#include <sched.h>
+
+static inline size_t slot_stride(size_t elem_size) {
+  size_t n = MPMC_DATA_OFFSET + elem_size;
+  return (n + MPMC_CACHE_LINE - 1) & ~((size_t) MPMC_CACHE_LINE - 1);
+}
+
+// Busy-wait step: pause for a while, then give the CPU away so a
+// preempted producer can finish its write
+static inline void backoff(unsigned *spins) {
+  if (*spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+    *spins += 1;
+  } else {
+    sched_yield();
+  }
+}
+
+// Bounded queue
+
+static inline atomic_size_t *mpmc_seq(mpmc_queue *q, size_t pos) {
+  return (atomic_size_t *) (q->slots + (pos & q->mask) * q->stride);
+}
+
+mpmc_queue *mpmc_init(mpmc_queue *q, size_t elem_size, size_t capacity) {
+  assert(q);
+  assert(elem_size > 0);
+
+  size_t c = 2;
+  while (c < capacity) {
+    c *= 2;
+  }
+
+  q->elem_size = elem_size;
+  q->stride = slot_stride(elem_size);
+  q->mask = c - 1;
+  q->slots = aligned_alloc(MPMC_CACHE_LINE, c * q->stride);
+  assert(q->slots);
+
+  // slot i is free for the producer at position i
+  for (size_t i = 0; i < c; i++) {
+    atomic_init(mpmc_seq(q, i), i);
+  }
+  atomic_init(&q->enqueue_pos, 0);
+  atomic_init(&q->dequeue_pos, 0);
+
+  return q;
+}
+
+void mpmc_destroy(mpmc_queue *q) {
+  assert(q);
+  free(q->slots);
+  q->slots = NULL;
+}
+
+bool mpmc_push(mpmc_queue *q, const void *elem) {
+  size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+  atomic_size_t *seq;
+
+  for (;;) {
+    seq = mpmc_seq(q, pos);
+    size_t s = atomic_load_explicit(seq, memory_order_acquire);
+    intptr_t diff = (intptr_t) s - (intptr_t) pos;
+    if (diff == 0) {
+      // slot is free for this lap, try to claim it
+      if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1,
+            memory_order_relaxed, memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // slot still holds an element from the previous lap
+      return false;
+    } else {
+      pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    }
+  }
+
+  memcpy((unsigned char *) seq + MPMC_DATA_OFFSET, elem, q->elem_size);
+  atomic_store_explicit(seq, pos + 1, memory_order_release);
+  return true;
+}
+
+bool mpmc_pop(mpmc_queue *q, void *elem) {
+  size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+  atomic_size_t *seq;
+
+  for (;;) {
+    seq = mpmc_seq(q, pos);
+    size_t s = atomic_load_explicit(seq, memory_order_acquire);
+    intptr_t diff = (intptr_t) s - (intptr_t) (pos + 1);
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos + 1,
+            memory_order_relaxed, memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // slot has not been written for this lap
+      return false;
+    } else {
+      pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    }
+  }
+
+  memcpy(elem, (unsigned char *) seq + MPMC_DATA_OFFSET, q->elem_size);
+  // free the slot for the producer one lap ahead
+  atomic_store_explicit(seq, pos + q->mask + 1, memory_order_release);
+  return true;
+}
+
+// Segmented queue
+
+// state word of a slot: 0 while empty, 1 once the element is written
+static inline atomic_size_t *sq_state(seg_queue *q, sq_segment *s, size_t i) {
+  return (atomic_size_t *) (s->slots + i * q->stride);
+}
+
+static sq_segment *sq_new_segment(seg_queue *q) {
+  sq_segment *s = aligned_alloc(MPMC_CACHE_LINE, sizeof(sq_segment) + q->capacity * q->stride);
+  assert(s);
+  atomic_init(&s->enq, 0);
+  atomic_init(&s->deq, 0);
+  atomic_init(&s->next, NULL);
+  s->retired_next = NULL;
+  for (size_t i = 0; i < q->capacity; i++) {
+    atomic_init(sq_state(q, s, i), 0);
+  }
+  return s;
+}
+
+static void sq_free_chain(sq_segment *s) {
+  while (s) {
+    sq_segment *next = s->retired_next;
+    free(s);
+    s = next;
+  }
+}
+
+// Pushes the chain first..last onto the retired list
+static void sq_push_retired(seg_queue *q, sq_segment *first, sq_segment *last) {
+  sq_segment *top = atomic_load(&q->retired);
+  do {
+    last->retired_next = top;
+  } while (!atomic_compare_exchange_weak(&q->retired, &top, first));
+}
+
+static inline void sq_enter(seg_queue *q) {
+  atomic_fetch_add(&q->inflight, 1);
+}
+
+// Frees retired segments if this was the last operation in flight.
+// Segments are retired after being unlinked, so an operation that starts
+// after the retired list has been taken can no longer reach them.
+static void sq_leave(seg_queue *q) {
+  if (atomic_fetch_sub(&q->inflight, 1) != 1) return;
+  if (!atomic_load(&q->retired)) return;
+
+  sq_segment *list = atomic_exchange(&q->retired, NULL);
+  if (!list) return;
+
+  if (atomic_load(&q->inflight) == 0) {
+    sq_free_chain(list);
+  } else {
+    // someone may still hold one of them, try again later
+    sq_segment *last = list;
+    while (last->retired_next) {
+      last = last->retired_next;
+    }
+    sq_push_retired(q, list, last);
+  }
+}
+
+seg_queue *sq_init(seg_queue *q, size_t elem_size, size_t segment_capacity) {
+  assert(q);
+  assert(elem_size > 0);
+
+  q->elem_size = elem_size;
+  q->capacity = segment_capacity ? segment_capacity : SQ_DEFAULT_SEGMENT;
+  q->stride = slot_stride(elem_size);
+
+  sq_segment *s = sq_new_segment(q);
+  atomic_init(&q->head, s);
+  atomic_init(&q->tail, s);
+  atomic_init(&q->inflight, 0);
+  atomic_init(&q->retired, NULL);
+
+  return q;
+}
+
+void sq_destroy(seg_queue *q) {
+  assert(q);
+  assert(atomic_load(&q->inflight) == 0);
+
+  sq_segment *s = atomic_load(&q->head);
+  while (s) {
+    sq_segment *next = atomic_load(&s->next);
+    free(s);
+    s = next;
+  }
+  sq_free_chain(atomic_load(&q->retired));
+
+  atomic_store(&q->head, NULL);
+  atomic_store(&q->tail, NULL);
+  atomic_store(&q->retired, NULL);
+}
+
+void sq_push(seg_queue *q, const void *elem) {
+  sq_enter(q);
+
+  for (;;) {
+    sq_segment *s = atomic_load(&q->tail);
+    size_t i = atomic_fetch_add(&s->enq, 1);
+    if (i < q->capacity) {
+      atomic_size_t *state = sq_state(q, s, i);
+      memcpy((unsigned char *) state + MPMC_DATA_OFFSET, elem, q->elem_size);
+      atomic_store_explicit(state, 1, memory_order_release);
+      break;
+    }
+
+    // segment is full, make sure it has a successor and move the tail on
+    sq_segment *next = atomic_load(&s->next);
+    if (!next) {
+      sq_segment *n = sq_new_segment(q);
+      if (atomic_compare_exchange_strong(&s->next, &next, n)) {
+        next = n;
+      } else {
+        free(n);
+      }
+    }
+    atomic_compare_exchange_strong(&q->tail, &s, next);
+  }
+
+  sq_leave(q);
+}
+
+bool sq_pop(seg_queue *q, void *elem) {
+  bool found = false;
+  sq_enter(q);
+
+  for (;;) {
+    sq_segment *s = atomic_load(&q->head);
+    size_t i = atomic_load(&s->deq);
+
+    if (i >= q->capacity) {
+      // segment drained, move on to its successor
+      sq_segment *next = atomic_load(&s->next);
+      if (!next) break;
+      if (atomic_compare_exchange_strong(&q->head, &s, next)) {
+        // the tail must not be left behind on a retired segment
+        sq_segment *t = s;
+        atomic_compare_exchange_strong(&q->tail, &t, next);
+        sq_push_retired(q, s, s);
+      }
+      continue;
+    }
+
+    if (i >= atomic_load(&s->enq)) break; // empty
+
+    if (atomic_compare_exchange_weak(&s->deq, &i, i + 1)) {
+      // the producer owning slot i may still be writing it
+      atomic_size_t *state = sq_state(q, s, i);
+      unsigned spins = 0;
+      while (atomic_load_explicit(state, memory_order_acquire) == 0) {
+        backoff(&spins);
+      }
+      memcpy(elem, (unsigned char *) state + MPMC_DATA_OFFSET, q->elem_size);
+      found = true;
+      break;
+    }
+  }
+
+  sq_leave(q);
+  return found;
+}
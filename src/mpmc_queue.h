@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+// Size of a cache line, used to keep hot atomics and slots apart
+#define MPMC_CACHE_LINE 64
+// Offset of the element inside a slot, after the slot's sequence/state word
+#define MPMC_DATA_OFFSET (sizeof(max_align_t))
+// Default number of elements per segment of a seg_queue
+#define SQ_DEFAULT_SEGMENT 1024
+
+// Bounded lock-free multi-producer/multi-consumer queue (Vyukov).
+// Each slot carries a sequence number telling producers and consumers
+// whether it is free for the current lap; slots are padded to cache lines.
+typedef struct mpmc_queue {
+  // slots, each 'stride' bytes long
+  unsigned char *slots;
+  size_t stride;
+  // capacity - 1, capacity is a power of two
+  size_t mask;
+  // size of an element in bytes
+  size_t elem_size;
+  // next position to be written
+  _Alignas(MPMC_CACHE_LINE) atomic_size_t enqueue_pos;
+  // next position to be read
+  _Alignas(MPMC_CACHE_LINE) atomic_size_t dequeue_pos;
+  char pad[MPMC_CACHE_LINE - sizeof(atomic_size_t)];
+} mpmc_queue;
+
+// Initializes q to hold capacity (rounded up to a power of two)
+// elements of elem_size bytes
+mpmc_queue *mpmc_init(mpmc_queue *q, size_t elem_size, size_t capacity);
+// Frees the slots of q
+void mpmc_destroy(mpmc_queue *q);
+// Copies elem into q. Returns false if q is full.
+bool mpmc_push(mpmc_queue *q, const void *elem);
+// Copies the oldest element of q into elem. Returns false if q is empty.
+bool mpmc_pop(mpmc_queue *q, void *elem);
+
+typedef struct sq_segment {
+  // slots claimed by producers and consumers, may exceed capacity
+  _Alignas(MPMC_CACHE_LINE) atomic_size_t enq;
+  _Alignas(MPMC_CACHE_LINE) atomic_size_t deq;
+  // following segment, installed by the producer that finds this one full
+  _Alignas(MPMC_CACHE_LINE) _Atomic(struct sq_segment *) next;
+  // link on the retired list
+  struct sq_segment *retired_next;
+  _Alignas(MPMC_CACHE_LINE) unsigned char slots[];
+} sq_segment;
+
+// Unbounded lock-free multi-producer/multi-consumer queue made of
+// fixed-size segments that are each filled once. Drained segments are
+// retired and freed once no operation is in flight.
+typedef struct seg_queue {
+  _Alignas(MPMC_CACHE_LINE) _Atomic(sq_segment *) head;
+  _Alignas(MPMC_CACHE_LINE) _Atomic(sq_segment *) tail;
+  // operations in progress, segments are only freed when it drops to 0
+  _Alignas(MPMC_CACHE_LINE) atomic_size_t inflight;
+  _Atomic(sq_segment *) retired;
+  // size of an element in bytes
+  size_t elem_size;
+  // slots per segment and bytes per slot
+  size_t capacity;
+  size_t stride;
+} seg_queue;
+
+// Initializes q for elements of elem_size bytes, with segments of
+// segment_capacity elements (SQ_DEFAULT_SEGMENT if 0)
+seg_queue *sq_init(seg_queue *q, size_t elem_size, size_t segment_capacity);
+// Frees every segment of q. No operation may be in flight.
+void sq_destroy(seg_queue *q);
+// Copies elem into q
+void sq_push(seg_queue *q, const void *elem);
+// Copies the oldest element of q into elem. Returns false if q is empty.
+bool sq_pop(seg_queue *q, void *elem);
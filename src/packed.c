@@ -0,0 +1,293 @@
+#include "packed.h"
+#include "stats.h"
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PACKED_X86
+#endif
+
+// Bytes of the values that follow each tag
+static uint8_t group_length[256];
+// Moves the bytes of each tag's values into four 32-bit lanes,
+// 0x80 zeroes the high bytes
+static uint8_t group_shuffle[256][16];
+// Whether packed_decode() may use SSSE3
+static bool use_simd = false;
+
+static void init_tables(void) {
+  static bool ready = false;
+  if (ready) return;
+  for (size_t tag = 0; tag < 256; tag++) {
+    size_t at = 0;
+    memset(group_shuffle[tag], 0x80, 16);
+    for (size_t j = 0; j < PACKED_GROUP; j++) {
+      size_t len = ((tag >> (2 * j)) & 3) + 1;
+      for (size_t b = 0; b < len; b++) {
+        group_shuffle[tag][4 * j + b] = (uint8_t) at++;
+      }
+    }
+    group_length[tag] = (uint8_t) at;
+  }
+#ifdef PACKED_X86
+  use_simd = __builtin_cpu_supports("ssse3");
+#endif
+  ready = true;
+}
+
+// Edge of a vertex being packed
+typedef struct packed_entry {
+  uint32_t y;
+  double weight;
+} packed_entry;
+
+static int entry_cmp(const void *a, const void *b) {
+  const packed_entry *x = a, *y = b;
+  if (x->y != y->y) return x->y < y->y ? -1 : 1;
+  return (x->weight > y->weight) - (x->weight < y->weight);
+}
+
+// Appends a group of values to out, returns the end of the group
+static uint8_t *encode_group(uint8_t *out, const uint32_t values[PACKED_GROUP]) {
+  uint8_t *tag = out++;
+  *tag = 0;
+  for (size_t j = 0; j < PACKED_GROUP; j++) {
+    uint32_t x = values[j];
+    size_t len = x < (1u << 8) ? 1 : x < (1u << 16) ? 2 : x < (1u << 24) ? 3 : 4;
+    *tag |= (uint8_t) ((len - 1) << (2 * j));
+    for (size_t b = 0; b < len; b++) {
+      *out++ = (uint8_t) (x >> (8 * b));
+    }
+  }
+  return out;
+}
+
+bool packed_graph(graph *g, const char **reason) {
+  assert(g);
+  assert(!g->compact && !g->packed);
+  compact_weights kind;
+  if (!compact_check(g, &kind, reason)) return false;
+  init_tables();
+
+  size_t n = g->nvertices;
+  size_t total = 0, max_degree = 0;
+  for (size_t v = 0; v < n; v++) {
+    total += g->degree[v];
+    if (g->degree[v] > max_degree) max_degree = g->degree[v];
+  }
+
+  packed_edges *p = calloc(1, sizeof(packed_edges));
+  assert(p);
+  p->kind = kind;
+  p->width = (max_degree + PACKED_GROUP - 1) / PACKED_GROUP * PACKED_GROUP;
+  if (p->width == 0) p->width = PACKED_GROUP;
+  p->offsets = calloc(n + 1, sizeof(size_t));
+  p->starts = calloc(n + 1, sizeof(size_t));
+  p->weights = kind == CW_UNIT ? NULL : calloc(total ? total : 1, compact_weight_size(kind));
+  assert(p->offsets && p->starts && (kind == CW_UNIT || p->weights));
+
+  // groups take at most 1 + 4 * PACKED_GROUP bytes, most far fewer
+  size_t capacity = total + PACKED_SLACK;
+  p->bytes = malloc(capacity);
+  packed_entry *entries = calloc(p->width, sizeof(packed_entry));
+  assert(p->bytes && entries);
+
+  size_t e = 0, at = 0;
+  for (size_t v = 0; v < n; v++) {
+    size_t d = 0;
+    for (edgenode *q = g->edges[v]; q; q = q->next) {
+      entries[d++] = (packed_entry) {(uint32_t) q->y, q->weight};
+    }
+    qsort(entries, d, sizeof(packed_entry), entry_cmp);
+
+    size_t groups = (d + PACKED_GROUP - 1) / PACKED_GROUP;
+    if (capacity - at < groups * (1 + 4 * PACKED_GROUP) + PACKED_SLACK) {
+      capacity = 2 * capacity + groups * (1 + 4 * PACKED_GROUP);
+      p->bytes = realloc(p->bytes, capacity);
+      assert(p->bytes);
+    }
+
+    p->offsets[v] = e;
+    p->starts[v] = at;
+    uint8_t *out = p->bytes + at;
+    uint32_t last = 0;
+    for (size_t k = 0; k < d; k += PACKED_GROUP) {
+      uint32_t gaps[PACKED_GROUP] = {0};
+      for (size_t j = 0; j < PACKED_GROUP && k + j < d; j++) {
+        gaps[j] = entries[k + j].y - last;
+        last = entries[k + j].y;
+      }
+      out = encode_group(out, gaps);
+    }
+    at = (size_t) (out - p->bytes);
+
+    for (size_t k = 0; k < d; k++, e++) {
+      switch (kind) {
+      case CW_U16: ((uint16_t *) p->weights)[e] = (uint16_t) entries[k].weight; break;
+      case CW_U32: ((uint32_t *) p->weights)[e] = (uint32_t) entries[k].weight; break;
+      case CW_FLOAT: ((float *) p->weights)[e] = (float) entries[k].weight; break;
+      default: break;
+      }
+    }
+  }
+  p->offsets[n] = e;
+  p->starts[n] = at;
+  assert(e == total);
+  free(entries);
+
+  // keep the slack decoders read past the end
+  p->bytes = realloc(p->bytes, at + PACKED_SLACK);
+  assert(p->bytes);
+  memset(p->bytes + at, 0, PACKED_SLACK);
+
+  // the lists are gone, degree stays for callers that size buffers
+  arena_destroy(&g->pool);
+  free(g->edges);
+  g->edges = NULL;
+  g->packed = p;
+  return true;
+}
+
+void packed_destroy(packed_edges *p) {
+  assert(p);
+  free(p->offsets);
+  free(p->starts);
+  free(p->bytes);
+  free(p->weights);
+  free(p);
+}
+
+size_t packed_bytes(const packed_edges *p, size_t nvertices) {
+  assert(p);
+  size_t total = p->offsets[nvertices];
+  return 2 * (nvertices + 1) * sizeof(size_t) + p->starts[nvertices] + PACKED_SLACK
+      + total * compact_weight_size(p->kind);
+}
+
+size_t packed_decode_scalar(const packed_edges *p, size_t v, uint32_t out[]) {
+  size_t d = p->offsets[v + 1] - p->offsets[v];
+  const uint8_t *in = p->bytes + p->starts[v];
+  uint32_t last = 0;
+  for (size_t k = 0; k < d; k += PACKED_GROUP) {
+    uint8_t tag = *in++;
+    for (size_t j = 0; j < PACKED_GROUP; j++) {
+      size_t len = ((tag >> (2 * j)) & 3) + 1;
+      uint32_t x = 0;
+      for (size_t b = 0; b < len; b++) {
+        x |= (uint32_t) in[b] << (8 * b);
+      }
+      in += len;
+      last += x;
+      out[k + j] = last;
+    }
+  }
+  return d;
+}
+
+#ifdef PACKED_X86
+// Each group is one unaligned load, a shuffle widening its values to
+// 32 bits and a prefix sum of the gaps in two shifted adds
+__attribute__((target("ssse3")))
+static size_t decode_ssse3(const packed_edges *p, size_t v, uint32_t out[]) {
+  size_t d = p->offsets[v + 1] - p->offsets[v];
+  const uint8_t *in = p->bytes + p->starts[v];
+  __m128i last = _mm_setzero_si128();
+  for (size_t k = 0; k < d; k += PACKED_GROUP) {
+    uint8_t tag = *in;
+    __m128i data = _mm_loadu_si128((const __m128i *) (in + 1));
+    __m128i mask = _mm_loadu_si128((const __m128i *) group_shuffle[tag]);
+    __m128i x = _mm_shuffle_epi8(data, mask);
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+    x = _mm_add_epi32(x, last);
+    _mm_storeu_si128((__m128i *) (out + k), x);
+    last = _mm_shuffle_epi32(x, 0xff);
+    in += 1 + group_length[tag];
+  }
+  return d;
+}
+#endif
+
+size_t packed_decode(const packed_edges *p, size_t v, uint32_t out[]) {
+#ifdef PACKED_X86
+  if (use_simd) return decode_ssse3(p, v, out);
+#endif
+  return packed_decode_scalar(p, v, out);
+}
+
+void packed_dijkstra(graph *g, size_t source, const size_t members[], size_t count,
+    double dist[], int prev[], priority_queue *pq) {
+  const packed_edges *p = g->packed;
+  assert(p);
+  assert(pq->max > count);
+  uint32_t *targets = malloc(p->width * sizeof(uint32_t));
+  assert(targets);
+  pq_clear(pq);
+  dist[source] = 0;
+
+  for (size_t k = 0; k < count; k++) {
+    size_t i = members ? members[k] : k;
+    if (i != source) {
+      dist[i] = INF;
+    }
+    prev[i] = -1;
+    pq_insert(pq, (int) i, dist[i]);
+  }
+
+  while (!pq_empty(pq)) {
+    size_t u = (size_t) pq_extract_min(pq);
+    size_t first = p->offsets[u];
+    size_t d = packed_decode(p, u, targets);
+    for (size_t k = 0; k < d; k++) {
+      STATS_COUNT(ST_RELAX);
+      size_t y = targets[k];
+      int i = pq_index_of(pq, (int) y);
+      if (i < 0) continue;
+
+      double alt = dist[u] + packed_weight(p, first + k);
+      if (alt < dist[y]) {
+        dist[y] = alt;
+        prev[y] = (int) u;
+        pq_decrease_priority(pq, (size_t) i, alt);
+      }
+    }
+  }
+  free(targets);
+}
+
+void packed_prim(graph *g, size_t source, const size_t members[], size_t count,
+    int parents[], double keys[], priority_queue *pq) {
+  const packed_edges *p = g->packed;
+  assert(p);
+  assert(pq->max >= count);
+  uint32_t *targets = malloc(p->width * sizeof(uint32_t));
+  assert(targets);
+  pq_clear(pq);
+
+  for (size_t k = 0; k < count; k++) {
+    size_t i = members ? members[k] : k;
+    keys[i] = INF;
+    parents[i] = -1;
+    pq_insert(pq, (int) i, INF);
+  }
+
+  pq_decrease_priority(pq, (size_t) pq_index_of(pq, (int) source), 0);
+  keys[source] = 0;
+
+  while (!pq_empty(pq)) {
+    int u = pq_extract_min(pq);
+    size_t first = p->offsets[u];
+    size_t d = packed_decode(p, (size_t) u, targets);
+    for (size_t k = 0; k < d; k++) {
+      STATS_COUNT(ST_RELAX);
+      size_t y = targets[k];
+      double w = packed_weight(p, first + k);
+      int i = pq_index_of(pq, (int) y);
+      if (i >= 0 && w < keys[y]) {
+        parents[y] = u;
+        keys[y] = w;
+        pq_decrease_priority(pq, (size_t) i, w);
+      }
+    }
+  }
+  free(targets);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include "graph.h"
+#include "compact.h"
+
+// Values a group shares one tag byte between
+#define PACKED_GROUP 4
+// Bytes readable past the last group, so decoders may load 16 at once
+#define PACKED_SLACK 16
+
+// Read-only edges of a graph with compressed targets.
+// The targets of v are sorted and stored as the first one followed by
+// the gaps between neighbours, in groups of PACKED_GROUP values: a tag
+// byte holding the byte length minus one of each value in two bits,
+// then the values in as many little-endian bytes. The last group of a
+// vertex is padded with zero gaps. Weights are stored apart as in
+// compact_edges, in the order of the sorted targets.
+typedef struct packed_edges {
+  // edges of v are offsets[v]..offsets[v + 1) in the weights
+  size_t *offsets;
+  // groups of v start at bytes[starts[v]]
+  size_t *starts;
+  uint8_t *bytes;
+  compact_weights kind;
+  // uint16_t, uint32_t or float per edge, NULL for CW_UNIT
+  void *weights;
+  // entries a decode buffer needs: the largest degree rounded up
+  // to PACKED_GROUP
+  size_t width;
+} packed_edges;
+
+// Weight of edge e
+static inline double packed_weight(const packed_edges *p, size_t e) {
+  return compact_weight_at(p->kind, p->weights, e);
+}
+
+// Moves the edges of g to packed storage and frees its adjacency lists.
+// Returns false and leaves g as it is if compact_check() refuses it.
+// Only searches, spanning trees and components run on packed graphs,
+// and as neighbours are visited in id order they may find other paths
+// or trees of equal cost.
+bool packed_graph(graph *g, const char **reason);
+
+void packed_destroy(packed_edges *p);
+
+// Bytes used by the packed edges
+size_t packed_bytes(const packed_edges *p, size_t nvertices);
+
+// Writes the targets of v to out, which holds p->width entries.
+// Decodes with SSSE3 shuffles where the processor has them.
+// Returns the degree of v.
+size_t packed_decode(const packed_edges *p, size_t v, uint32_t out[]);
+// packed_decode() one byte at a time
+size_t packed_decode_scalar(const packed_edges *p, size_t v, uint32_t out[]);
+
+// dijkstra_subset() and prim_subset() on packed edges
+void packed_dijkstra(graph *g, size_t source, const size_t members[], size_t count,
+    double dist[], int prev[], priority_queue *pq);
+void packed_prim(graph *g, size_t source, const size_t members[], size_t count,
+    int parents[], double keys[], priority_queue *pq);
@@ -1,6 +1,8 @@
 #include "priority_queue.h"
+#include "stats.h"
 
 void swap(priority_queue *pq, size_t i, size_t j) {
+  STATS_COUNT(ST_PQ_SWAP);
   // if values are in hash table, update the indices
   if (ht_get_value(pq->ht, &pq->a[i]->elem, 0)) {
     ht_set_value(pq->ht, &pq->a[i]->elem, &j);
@@ -46,12 +48,17 @@ priority_queue *pq_init(priority_queue *pq, size_t max) {
   pq->a = calloc(max, sizeof(pair *));
   assert(pq->a);
 
+  arena_init(&pq->pool, 0);
+
   pq->ht = ht_init(calloc(1, sizeof(hash_table)), sizeof(int), sizeof(int), 2 * max);
   assert(pq->ht);
+  pq->ht->pool = &pq->pool;
+
+  // all pairs in a single allocation
+  pair *pairs = arena_alloc(&pq->pool, max * sizeof(pair));
 
   for (size_t i = 0; i < max; ++i) {
-   pq->a[i] = calloc(1, sizeof(pair));
-   assert(pq->a[i]);
+   pq->a[i] = &pairs[i];
    pq->a[i]->elem = -1;
    pq->a[i]->priority = INFINITY;
   }
@@ -65,17 +72,26 @@ priority_queue *pq_init(priority_queue *pq, size_t max) {
 void pq_destroy(priority_queue *pq) {
   assert(pq);
   assert(pq->a);
-  for (size_t i = 0; i < pq->max; i++) {
-    free(pq->a[i]);
-  }
   ht_destroy(pq->ht);
   free(pq->ht);
   free(pq->a);
+  arena_destroy(&pq->pool);
+}
+
+// O(size)
+void pq_clear(priority_queue *pq) {
+  assert(pq);
+  assert(pq->a);
+  for (size_t i = 0; i < pq->size; i++) {
+    ht_remove(pq->ht, &pq->a[i]->elem);
+  }
+  pq->size = 0;
 }
 
 // O(lg n)
 // On worst case, inserted key will be shifted all the way up
 void pq_insert(priority_queue *pq, int elem, double priority) {
+  STATS_COUNT(ST_PQ_INSERT);
   assert(pq);
   assert(pq->a);
   assert(pq->size < pq->max);
@@ -103,6 +119,7 @@ int pq_minimum(priority_queue *pq) {
 // O(lg n)
 // Constant operations, plus call to O(lg n) procedure
 int pq_extract_min(priority_queue *pq) {
+  STATS_COUNT(ST_PQ_EXTRACT);
   assert(pq);
   assert(pq->a);
   assert(pq->size > 0);
@@ -122,6 +139,7 @@ int pq_extract_min(priority_queue *pq) {
 // On worst case, leave will go all the way to the top,
 // taking h = lg n operations
 void pq_decrease_priority(priority_queue *pq, size_t i, double priority) {
+  STATS_COUNT(ST_PQ_DECREASE);
   assert(pq);
   assert(pq->a);
   assert(i < pq->max);
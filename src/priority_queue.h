@@ -26,6 +26,8 @@ typedef struct priority_queue {
   size_t max;
   size_t size;
   hash_table *ht;
+  // backing storage for the pairs and the index table entries
+  arena pool;
 } priority_queue;
 
 // Basics
@@ -44,6 +46,8 @@ void min_heapify(priority_queue *pq, size_t i);
 priority_queue *pq_init(priority_queue *pq, size_t max);
 // destroys priority queue instance
 void pq_destroy(priority_queue *pq);
+// removes every element, keeping the storage for reuse
+void pq_clear(priority_queue *pq);
 // inserts value with priority in pq
 void pq_insert(priority_queue *pq, int value, double priority);
 // returns the value of the element with least priority  stored in the queue
@@ -0,0 +1,181 @@
+#include "reorder.h"
+
+typedef struct degree_item {
+  size_t degree;
+  size_t v;
+} degree_item;
+
+// Ascending degree, ties by vertex so orders are deterministic
+static int degree_asc(const void *a, const void *b) {
+  const degree_item *x = a, *y = b;
+  if (x->degree != y->degree) return x->degree < y->degree ? -1 : 1;
+  return x->v < y->v ? -1 : x->v > y->v;
+}
+
+static int degree_desc(const void *a, const void *b) {
+  const degree_item *x = a, *y = b;
+  if (x->degree != y->degree) return x->degree > y->degree ? -1 : 1;
+  return x->v < y->v ? -1 : x->v > y->v;
+}
+
+// Breadth-first order of every component, written to order.
+// order doubles as the queue. Components start from their first vertex
+// in 'starts'; with by_degree, neighbours are visited by ascending degree.
+static void bfs_order(graph *g, const size_t starts[], bool by_degree, size_t order[]) {
+  size_t n = g->nvertices;
+  bool *seen = calloc(n, sizeof(bool));
+  degree_item *nbrs = by_degree ? calloc(n, sizeof(degree_item)) : NULL;
+  assert(seen && (nbrs || !by_degree));
+
+  size_t tail = 0;
+  for (size_t s = 0; s < n; s++) {
+    if (seen[starts[s]]) continue;
+    seen[starts[s]] = true;
+    order[tail++] = starts[s];
+
+    for (size_t head = tail - 1; head < tail; head++) {
+      size_t u = order[head];
+      size_t k = 0;
+      for (edgenode *p = g->edges[u]; p; p = p->next) {
+        if (seen[p->y]) continue;
+        seen[p->y] = true;
+        if (by_degree) {
+          nbrs[k++] = (degree_item) {g->degree[p->y], p->y};
+        } else {
+          order[tail++] = p->y;
+        }
+      }
+      if (by_degree) {
+        qsort(nbrs, k, sizeof(degree_item), degree_asc);
+        for (size_t i = 0; i < k; i++) {
+          order[tail++] = nbrs[i].v;
+        }
+      }
+    }
+  }
+  assert(tail == n);
+
+  free(seen);
+  free(nbrs);
+}
+
+void compute_order(graph *g, vertex_order kind, size_t order[]) {
+  assert(g);
+  assert(order);
+  size_t n = g->nvertices;
+
+  if (kind == ORDER_NONE || kind == ORDER_BFS) {
+    for (size_t v = 0; v < n; v++) {
+      order[v] = v;
+    }
+    if (kind == ORDER_BFS) {
+      size_t *starts = calloc(n, sizeof(size_t));
+      assert(starts);
+      memcpy(starts, order, n * sizeof(size_t));
+      bfs_order(g, starts, false, order);
+      free(starts);
+    }
+    return;
+  }
+
+  degree_item *items = calloc(n, sizeof(degree_item));
+  assert(items);
+  for (size_t v = 0; v < n; v++) {
+    items[v] = (degree_item) {g->degree[v], v};
+  }
+
+  if (kind == ORDER_DEGREE) {
+    qsort(items, n, sizeof(degree_item), degree_desc);
+    for (size_t v = 0; v < n; v++) {
+      order[v] = items[v].v;
+    }
+    free(items);
+    return;
+  }
+
+  // Cuthill-McKee grows each component from a vertex of lowest degree,
+  // then the whole order is reversed
+  assert(kind == ORDER_RCM);
+  qsort(items, n, sizeof(degree_item), degree_asc);
+  size_t *starts = calloc(n, sizeof(size_t));
+  assert(starts);
+  for (size_t v = 0; v < n; v++) {
+    starts[v] = items[v].v;
+  }
+  free(items);
+
+  bfs_order(g, starts, true, order);
+  free(starts);
+
+  for (size_t i = 0, j = n; i + 1 < j; i++, j--) {
+    size_t t = order[i];
+    order[i] = order[j - 1];
+    order[j - 1] = t;
+  }
+}
+
+void relabel_graph(graph *g, const size_t order[]) {
+  assert(g);
+  assert(order);
+  size_t n = g->nvertices;
+
+  size_t *index = calloc(n, sizeof(size_t));
+  assert(index);
+  for (size_t k = 0; k < n; k++) {
+    assert(order[k] < n);
+    index[order[k]] = k;
+  }
+
+  edgenode **edges = calloc(n, sizeof(edgenode *));
+  size_t *degree = calloc(n, sizeof(size_t));
+  assert(edges && degree);
+
+  // fresh arena, filled in the new vertex order
+  arena pool;
+  arena_init(&pool, 0);
+  for (size_t k = 0; k < n; k++) {
+    edgenode **tail = &edges[k];
+    for (edgenode *p = g->edges[order[k]]; p; p = p->next) {
+      edgenode *q = arena_alloc(&pool, sizeof(edgenode));
+      q->y = index[p->y];
+      q->weight = p->weight;
+      q->next = NULL;
+      *tail = q;
+      tail = &q->next;
+    }
+    degree[k] = g->degree[order[k]];
+  }
+
+  arena_destroy(&g->pool);
+  free(g->edges);
+  free(g->degree);
+  g->pool = pool;
+  g->edges = edges;
+  g->degree = degree;
+
+  // label[k] = original id of the vertex that was order[k]
+  size_t *label = calloc(n, sizeof(size_t));
+  assert(label);
+  for (size_t k = 0; k < n; k++) {
+    label[k] = graph_label(g, order[k]);
+  }
+  free(g->label);
+  g->label = label;
+
+  free(g->index);
+  g->index = index;
+  for (size_t k = 0; k < n; k++) {
+    g->index[label[k]] = k;
+  }
+}
+
+void reorder_graph(graph *g, vertex_order kind) {
+  assert(g);
+  if (kind == ORDER_NONE) return;
+
+  size_t *order = calloc(g->nvertices, sizeof(size_t));
+  assert(order);
+  compute_order(g, kind, order);
+  relabel_graph(g, order);
+  free(order);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "graph.h"
+
+// Vertex orderings relabel_graph() can apply
+typedef enum vertex_order {
+  ORDER_NONE,   // keep the input order
+  ORDER_RCM,    // reverse Cuthill-McKee, keeps neighbours close together
+  ORDER_DEGREE, // highest degree first, hubs share cache lines
+  ORDER_BFS     // breadth-first discovery order
+} vertex_order;
+
+// Fills order with a permutation of g's vertices:
+// order[k] is the vertex that becomes vertex k.
+// Components are ordered one after the other.
+void compute_order(graph *g, vertex_order kind, size_t order[]);
+
+// Renames vertex order[k] of g to k, keeping the edges of each vertex
+// in their order and packing them contiguously in vertex order.
+// g->label and g->index map between new vertices and original ids,
+// composing with any earlier relabeling.
+void relabel_graph(graph *g, const size_t order[]);
+
+// compute_order() followed by relabel_graph(). Does nothing for ORDER_NONE.
+void reorder_graph(graph *g, vertex_order kind);
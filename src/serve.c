@@ -0,0 +1,256 @@
+#include "serve.h"
+#include "graph_io.h"
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+server *server_init(server *s, graph *g, landmarks *lm, contraction_hierarchy *ch,
+    dd_engine engine, size_t cache_bytes, const char *spill_dir) {
+  assert(s);
+  assert(g);
+  size_t n = g->nvertices;
+
+  s->g = g;
+  s->lm = lm;
+  s->ch = ch;
+  s->engine = engine;
+  s->table = NULL;
+  s->dists = calloc(n, sizeof(double));
+  s->prev = calloc(n, sizeof(int));
+  s->parents = calloc(n, sizeof(int));
+  s->keys = calloc(n, sizeof(double));
+  assert(s->dists && s->prev && s->parents && s->keys);
+  pq_init(&s->pq, n + 1);
+  find_components(g, &s->cc, g->nthreads);
+  sssp_cache_init(&s->cache, cache_bytes, spill_dir);
+  s->fingerprint = graph_fingerprint(g);
+
+  return s;
+}
+
+void server_destroy(server *s) {
+  assert(s);
+  free(s->dists);
+  free(s->prev);
+  free(s->parents);
+  free(s->keys);
+  pq_destroy(&s->pq);
+  components_destroy(&s->cc);
+  sssp_cache_destroy(&s->cache);
+  if (s->table) {
+    ht_destroy(s->table);
+    free(s->table);
+  }
+}
+
+// Input of a session, read in blocks
+typedef struct line_reader {
+  int fd;
+  char buf[SERVE_BUFFER];
+  size_t start;
+  size_t end;
+  // flushed before each read, so pipelined commands are answered together
+  FILE *out;
+} line_reader;
+
+// Returns the next line without its newline, NULL at the end of the input.
+// Lines longer than the buffer are cut.
+static char *read_line(line_reader *r) {
+  for (;;) {
+    char *nl = memchr(r->buf + r->start, '\n', r->end - r->start);
+    if (nl) {
+      char *line = r->buf + r->start;
+      *nl = '\0';
+      r->start = (size_t) (nl - r->buf) + 1;
+      return line;
+    }
+
+    if (r->start > 0) {
+      memmove(r->buf, r->buf + r->start, r->end - r->start);
+      r->end -= r->start;
+      r->start = 0;
+    }
+    if (r->end == sizeof(r->buf) - 1) {
+      // too long, hand out what there is
+      r->buf[r->end] = '\0';
+      r->end = 0;
+      return r->buf;
+    }
+
+    fflush(r->out);
+    ssize_t got = read(r->fd, r->buf + r->end, sizeof(r->buf) - 1 - r->end);
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) {
+      if (r->end == 0) return NULL;
+      // last line without a newline
+      r->buf[r->end] = '\0';
+      r->end = 0;
+      return r->buf;
+    }
+    r->end += (size_t) got;
+  }
+}
+
+// Parses a 1-based vertex id, returns false if it is not one of g's
+static bool parse_vertex(graph *g, const char *arg, size_t *v) {
+  int id = arg ? atoi(arg) : 0;
+  if (id <= 0 || (size_t) id > g->nvertices) {
+    return false;
+  }
+  *v = graph_vertex(g, (size_t) id - 1);
+  return true;
+}
+
+static void answer_path(server *s, const char *from, const char *to, writer *out) {
+  graph *g = s->g;
+  size_t a, b;
+  if (!from || !to) {
+    writer_str(out, "Usage: path start end\n");
+    return;
+  }
+  if (!parse_vertex(g, from, &a)) {
+    writer_printf(out, "Invalid vertex '%s'.\n", from);
+    return;
+  }
+
+  if (to[0] == '.') {
+    sssp_entry *e = sssp_cache_get(&s->cache, g, s->fingerprint, a, &s->pq);
+    for (size_t i = 0; i < g->nvertices; i++) {
+      size_t v = graph_vertex(g, i);
+      if (v == a) continue;
+      path(g, a, v, e->dist, e->prev, out);
+    }
+    return;
+  }
+
+  if (!parse_vertex(g, to, &b)) {
+    writer_printf(out, "Invalid vertex '%s'.\n", to);
+    return;
+  }
+
+  // no path leaves a component
+  if (s->cc.id[a] != s->cc.id[b]) {
+    s->dists[b] = INF;
+    s->prev[b] = -1;
+    path(g, a, b, s->dists, s->prev, out);
+    return;
+  }
+
+  // a cached tree answers right away, the hierarchy and A* beat
+  // building a new one
+  sssp_entry *e = sssp_cache_find(&s->cache, s->fingerprint, a, g->nvertices);
+  if (!e && s->ch) {
+    ch_query(s->ch, a, b, s->dists, s->prev);
+    path(g, a, b, s->dists, s->prev, out);
+    return;
+  }
+  if (!e && s->lm) {
+    astar(g, s->lm, a, b, s->dists, s->prev);
+    path(g, a, b, s->dists, s->prev, out);
+    return;
+  }
+  if (!e) {
+    e = sssp_cache_get(&s->cache, g, s->fingerprint, a, &s->pq);
+  }
+  path(g, a, b, e->dist, e->prev, out);
+}
+
+bool server_session(server *s, int fd, FILE *out) {
+  assert(s);
+  line_reader *r = malloc(sizeof(line_reader));
+  assert(r);
+  r->fd = fd;
+  r->start = r->end = 0;
+  r->out = out;
+  // responses are formatted here and handed to out after each command
+  writer w;
+  writer_stdio(&w, out);
+
+  bool running = true;
+  char *line;
+  while ((line = read_line(r))) {
+    char *save;
+    char *cmd = strtok_r(line, " \t\r", &save);
+    if (!cmd) continue;
+
+    if (strcmp(cmd, "path") == 0) {
+      char *from = strtok_r(NULL, " \t\r", &save);
+      char *to = strtok_r(NULL, " \t\r", &save);
+      answer_path(s, from, to, &w);
+    } else if (strcmp(cmd, "mst") == 0) {
+      spanning_forest(s->g, &s->cc, s->parents, s->keys, &s->pq);
+      print_mst(s->g, &s->cc, s->parents, s->keys, &w);
+    } else if (strcmp(cmd, "distribution") == 0) {
+      if (!s->table) {
+        s->table = calloc(1, sizeof(hash_table));
+        assert(s->table);
+        distance_distribution_engine(s->g, s->table, s->engine);
+      }
+      print_distribution(s->g, s->table, &w);
+    } else if (strcmp(cmd, "quit") == 0) {
+      running = false;
+      break;
+    } else {
+      writer_printf(&w, "Invalid command '%s'.\n", cmd);
+    }
+    writer_char(&w, '\n');
+    writer_flush(&w);
+  }
+
+  writer_close(&w);
+  fflush(out);
+  free(r);
+  return running;
+}
+
+bool server_listen(server *s, const char *path) {
+  assert(s);
+  assert(path);
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    return false;
+  }
+  strcpy(addr.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  unlink(path);
+  if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+    close(fd);
+    return false;
+  }
+
+  // a client hanging up mid-response must not end the server
+  signal(SIGPIPE, SIG_IGN);
+
+  char *buffer = malloc(SERVE_BUFFER);
+  assert(buffer);
+  bool running = true;
+  while (running) {
+    int conn = accept(fd, NULL, NULL);
+    if (conn < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    FILE *out = fdopen(dup(conn), "w");
+    if (out) {
+      setvbuf(out, buffer, _IOFBF, SERVE_BUFFER);
+      running = server_session(s, conn, out);
+      fclose(out);
+    }
+    close(conn);
+  }
+
+  free(buffer);
+  close(fd);
+  unlink(path);
+  return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "graph.h"
+#include "landmarks.h"
+#include "ch.h"
+#include "sssp_cache.h"
+#include "components.h"
+
+// Size of the buffers commands are read into and responses written from
+#define SERVE_BUFFER (1 << 16)
+
+// Answers queries on a graph loaded once. Commands, one per line:
+//   path a b      shortest path between a and b
+//   path a .      shortest paths from a to every other vertex
+//   mst           minimum spanning tree
+//   distribution  distance distribution, computed on first request
+//   quit          ends the session
+// Responses use the format of the command line operations and end with
+// an empty line.
+typedef struct server {
+  graph *g;
+  // landmarks for A* path queries, NULL to run dijkstra
+  landmarks *lm;
+  // hierarchy answering path a b, NULL to search the graph
+  contraction_hierarchy *ch;
+  // buffers reused by every query
+  double *dists;
+  int *prev;
+  int *parents;
+  double *keys;
+  priority_queue pq;
+  // components, found once when the server starts
+  components cc;
+  // shortest path trees of recent sources
+  sssp_cache cache;
+  uint64_t fingerprint;
+  // distance distribution, NULL until asked for
+  hash_table *table;
+  dd_engine engine;
+} server;
+
+// Prepares s to answer queries on g, allocating the query buffers.
+// lm and ch may be NULL. Trees of up to cache_bytes are kept in memory
+// and spilled to spill_dir if it is not NULL.
+server *server_init(server *s, graph *g, landmarks *lm, contraction_hierarchy *ch,
+    dd_engine engine, size_t cache_bytes, const char *spill_dir);
+
+// Frees the buffers and the cache of s, not the graph, the landmarks or
+// the hierarchy
+void server_destroy(server *s);
+
+// Answers the commands read from fd on out until the input ends or
+// quit is received, which is reported by returning false.
+// Responses are buffered and flushed whenever reading would block.
+bool server_session(server *s, int fd, FILE *out);
+
+// Listens on a Unix socket at path and serves one connection at a time
+// until a client sends quit. Returns false if the socket cannot be set up.
+bool server_listen(server *s, const char *path);
@@ -0,0 +1,179 @@
+#include "sssp_cache.h"
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Bytes of a tree over n vertices, dist then prev
+static size_t tree_bytes(size_t n) {
+  return n * (sizeof(double) + sizeof(int));
+}
+
+// Both halves of the key, the default hash only reads the first word
+static size_t key_hash(const void *key) {
+  const sssp_key *k = key;
+  uint64_t h = k->fingerprint ^ (k->source * 0x9e3779b97f4a7c15ULL);
+  return (size_t) (h ^ (h >> 29));
+}
+
+sssp_cache *sssp_cache_init(sssp_cache *c, size_t budget, const char *spill_dir) {
+  assert(c);
+  ht_init(&c->index, sizeof(sssp_key), sizeof(sssp_entry *), HT_DEFAULT_SIZE);
+  c->index.hash_func = key_hash;
+  initIList(&c->lru);
+  c->budget = budget;
+  c->used = 0;
+  c->spill_dir = spill_dir ? strdup(spill_dir) : NULL;
+  c->hits = c->loads = c->misses = 0;
+  return c;
+}
+
+// Spill file of key, to be freed by the caller
+static char *spill_path(sssp_cache *c, const sssp_key *key) {
+  size_t len = strlen(c->spill_dir) + 64;
+  char *path = malloc(len);
+  assert(path);
+  snprintf(path, len, "%s/%016llx-%llu" SSSP_CACHE_SUFFIX, c->spill_dir,
+      (unsigned long long) key->fingerprint, (unsigned long long) key->source);
+  return path;
+}
+
+// Writes e to the spill directory, failures only cost a recomputation
+static void spill(sssp_cache *c, sssp_entry *e) {
+  char *path = spill_path(c, &e->key);
+  FILE *f = fopen(path, "wb");
+  if (f) {
+    bool ok = fwrite(e->dist, sizeof(double), e->nvertices, f) == e->nvertices &&
+      fwrite(e->prev, sizeof(int), e->nvertices, f) == e->nvertices;
+    ok = fclose(f) == 0 && ok;
+    if (!ok) {
+      remove(path);
+    }
+    e->spilled = ok;
+  }
+  free(path);
+}
+
+static void release(sssp_cache *c, sssp_entry *e) {
+  ht_remove(&c->index, &e->key);
+  ilistRemove(&c->lru, &e->link);
+  c->used -= tree_bytes(e->nvertices);
+  if (e->map) {
+    munmap(e->map, tree_bytes(e->nvertices));
+  } else {
+    free(e->dist);
+  }
+  free(e);
+}
+
+// Evicts least recently used trees until the budget is met,
+// always keeping the most recent one
+static void evict(sssp_cache *c) {
+  while (c->used > c->budget && ilistCount(&c->lru) > 1) {
+    sssp_entry *e = ILIST_ENTRY(ilistLast(&c->lru), sssp_entry, link);
+    if (c->spill_dir && !e->spilled) {
+      spill(c, e);
+    }
+    release(c, e);
+  }
+}
+
+static sssp_entry *add(sssp_cache *c, sssp_key key, size_t n) {
+  sssp_entry *e = calloc(1, sizeof(sssp_entry));
+  assert(e);
+  e->key = key;
+  e->nvertices = n;
+  ht_insert(&c->index, &key, &e);
+  ilistPushFront(&c->lru, &e->link);
+  c->used += tree_bytes(n);
+  return e;
+}
+
+// Maps the spill file of key, if there is one of the right size
+static sssp_entry *load(sssp_cache *c, sssp_key key, size_t n) {
+  char *path = spill_path(c, &key);
+  int fd = open(path, O_RDONLY);
+  free(path);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  struct stat st;
+  void *map = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (size_t) st.st_size == tree_bytes(n) && n > 0) {
+    map = mmap(NULL, tree_bytes(n), PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (map == MAP_FAILED) {
+    return NULL;
+  }
+
+  sssp_entry *e = add(c, key, n);
+  e->map = map;
+  e->dist = map;
+  e->prev = (int *) ((char *) map + n * sizeof(double));
+  e->spilled = true;
+  return e;
+}
+
+sssp_entry *sssp_cache_find(sssp_cache *c, uint64_t fingerprint, size_t source, size_t nvertices) {
+  assert(c);
+  sssp_key key = {fingerprint, source};
+
+  sssp_entry *e;
+  if (ht_get_value(&c->index, &key, &e)) {
+    c->hits++;
+    ilistRemove(&c->lru, &e->link);
+    ilistPushFront(&c->lru, &e->link);
+    return e;
+  }
+
+  if (c->spill_dir && (e = load(c, key, nvertices))) {
+    c->loads++;
+    evict(c);
+    return e;
+  }
+  return NULL;
+}
+
+sssp_entry *sssp_cache_get(sssp_cache *c, graph *g, uint64_t fingerprint, size_t source,
+    priority_queue *pq) {
+  assert(c);
+  assert(g);
+  assert(source < g->nvertices);
+
+  sssp_entry *e = sssp_cache_find(c, fingerprint, source, g->nvertices);
+  if (e) {
+    return e;
+  }
+
+  c->misses++;
+  size_t n = g->nvertices;
+  e = add(c, (sssp_key) {fingerprint, source}, n);
+  // one block for both arrays, laid out like a spill file
+  e->dist = malloc(tree_bytes(n));
+  assert(e->dist);
+  e->prev = (int *) (e->dist + n);
+  if (pq) {
+    dijkstra_pq(g, source, e->dist, e->prev, pq);
+  } else {
+    dijkstra(g, source, e->dist, e->prev);
+  }
+
+  evict(c);
+  return e;
+}
+
+void sssp_cache_destroy(sssp_cache *c) {
+  assert(c);
+  while (!ilistIsEmpty(&c->lru)) {
+    sssp_entry *e = ILIST_ENTRY(ilistFirst(&c->lru), sssp_entry, link);
+    if (c->spill_dir && !e->spilled) {
+      spill(c, e);
+    }
+    release(c, e);
+  }
+  ht_destroy(&c->index);
+  free(c->spill_dir);
+}
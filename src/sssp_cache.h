@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "graph.h"
+#include "ilist.h"
+
+// Default memory budget of the cache
+#define SSSP_CACHE_DEFAULT_BYTES ((size_t) 64 << 20)
+// Suffix of the files trees are spilled to
+#define SSSP_CACHE_SUFFIX ".sssp"
+
+// Identifies a shortest path tree: the graph's fingerprint and the source
+typedef struct sssp_key {
+  uint64_t fingerprint;
+  uint64_t source;
+} sssp_key;
+
+// Shortest path tree of one source, as filled by dijkstra().
+// The arrays are read-only, trees loaded from a spill file are mapped.
+typedef struct sssp_entry {
+  sssp_key key;
+  size_t nvertices;
+  double *dist;
+  int *prev;
+  // mapping backing dist and prev, NULL when they are on the heap
+  void *map;
+  // whether the tree is already in the spill directory
+  bool spilled;
+  // position in the recency list
+  IListNode link;
+} sssp_entry;
+
+// Shortest path trees kept by source, least recently used first out
+// once their size exceeds the budget. Evicted trees may be spilled to
+// files in a directory and mapped back when asked for again.
+typedef struct sssp_cache {
+  // sssp_key -> sssp_entry *
+  hash_table index;
+  // most recently used first
+  IList lru;
+  // bytes of trees the cache may hold, and hold now
+  size_t budget;
+  size_t used;
+  // directory trees are spilled to, NULL to drop them
+  char *spill_dir;
+  // lookups answered from memory, from spill files, and computed
+  size_t hits;
+  size_t loads;
+  size_t misses;
+} sssp_cache;
+
+// Initializes an empty cache of budget bytes. spill_dir may be NULL.
+sssp_cache *sssp_cache_init(sssp_cache *c, size_t budget, const char *spill_dir);
+
+// Frees every tree, spilling those not on disk yet when spilling is on,
+// so later runs can map them
+void sssp_cache_destroy(sssp_cache *c);
+
+// Tree of source on the graph with the given fingerprint, from memory or
+// the spill directory. NULL if it is in neither.
+sssp_entry *sssp_cache_find(sssp_cache *c, uint64_t fingerprint, size_t source, size_t nvertices);
+
+// Tree of source on g, computed on a miss with dijkstra_pq() on pq, or
+// dijkstra() if pq is NULL. fingerprint is graph_fingerprint(g).
+// The entry stays valid until the next call that may evict it.
+sssp_entry *sssp_cache_get(sssp_cache *c, graph *g, uint64_t fingerprint, size_t source,
+    priority_queue *pq);
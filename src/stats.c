@@ -0,0 +1,56 @@
+#include "stats.h"
+#include <time.h>
+#include <sys/resource.h>
+
+run_stats stats;
+
+static const char *counter_names[ST_COUNTERS] = {
+  "pq_insert", "pq_extract_min", "pq_decrease_priority", "pq_swap",
+  "ht_insert", "ht_get_value", "ht_set_value", "ht_remove",
+  "list_insert", "list_remove", "edge_relaxations"
+};
+
+static const char *phase_names[SP_PHASES] = {
+  "load", "prepare", "compute", "output"
+};
+
+double stats_clock(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double) t.tv_sec + (double) t.tv_nsec * 1e-9;
+}
+
+void stats_begin(stats_phase p) {
+  stats.started[p] = stats_clock();
+}
+
+void stats_end(stats_phase p) {
+  stats.seconds[p] += stats_clock() - stats.started[p];
+}
+
+size_t stats_peak_rss(void) {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  // kilobytes on Linux
+  return (size_t) usage.ru_maxrss * 1024;
+}
+
+void stats_print(FILE *fp) {
+#ifdef GRAPH_STATS
+  fprintf(fp, "{\"enabled\": true, \"phases\": {");
+  for (int p = 0; p < SP_PHASES; p++) {
+    fprintf(fp, "%s\"%s\": %.6f", p ? ", " : "", phase_names[p], stats.seconds[p]);
+  }
+  fprintf(fp, "}, \"counters\": {");
+  for (int c = 0; c < ST_COUNTERS; c++) {
+    fprintf(fp, "%s\"%s\": %llu", c ? ", " : "", counter_names[c],
+        (unsigned long long) stats.counters[c]);
+  }
+  fprintf(fp, "}, ");
+#else
+  (void) counter_names;
+  (void) phase_names;
+  fprintf(fp, "{\"enabled\": false, ");
+#endif
+  fprintf(fp, "\"peak_rss_bytes\": %zu}\n", stats_peak_rss());
+}
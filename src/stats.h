@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Operations counted in builds with -DGRAPH_STATS (make STATS=1)
+typedef enum stats_counter {
+  ST_PQ_INSERT,
+  ST_PQ_EXTRACT,
+  ST_PQ_DECREASE,
+  ST_PQ_SWAP,
+  ST_HT_INSERT,
+  ST_HT_GET,
+  ST_HT_SET,
+  ST_HT_REMOVE,
+  ST_LIST_INSERT,
+  ST_LIST_REMOVE,
+  ST_RELAX,     // edges scanned by searches and spanning trees
+  ST_COUNTERS
+} stats_counter;
+
+// Phases of a run, timed in the same builds
+typedef enum stats_phase {
+  SP_LOAD,      // reading the input
+  SP_PREPARE,   // dedup, reordering, compaction, components
+  SP_COMPUTE,   // the operation itself
+  SP_OUTPUT,    // printing results
+  SP_PHASES
+} stats_phase;
+
+typedef struct run_stats {
+  uint64_t counters[ST_COUNTERS];
+  // total seconds spent in each phase
+  double seconds[SP_PHASES];
+  // start of the running interval of each phase
+  double started[SP_PHASES];
+} run_stats;
+
+// Counters and timers of this process
+extern run_stats stats;
+
+#ifdef GRAPH_STATS
+// relaxed atomics, so threads may count without locks
+#define STATS_COUNT(c) ((void) __atomic_fetch_add(&stats.counters[c], 1, __ATOMIC_RELAXED))
+#define STATS_BEGIN(p) stats_begin(p)
+#define STATS_END(p) stats_end(p)
+#else
+#define STATS_COUNT(c) ((void) 0)
+#define STATS_BEGIN(p) ((void) 0)
+#define STATS_END(p) ((void) 0)
+#endif
+
+// Seconds on the monotonic clock
+double stats_clock(void);
+
+void stats_begin(stats_phase p);
+void stats_end(stats_phase p);
+
+// Peak resident set size of the process in bytes
+size_t stats_peak_rss(void);
+
+// Prints the counters, timers and peak memory to fp as a JSON object.
+// Builds without GRAPH_STATS only report peak memory.
+void stats_print(FILE *fp);
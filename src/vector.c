@@ -0,0 +1,135 @@
+#include "vector.h"
+#include <string.h>
+#include <assert.h>
+
+static inline void *slotRef(Vector *v, uint64_t i) {
+  return v->data + i * v->size;
+}
+
+// Moves the elements to a buffer of capacity slots
+static void resize(Vector *v, size_t capacity) {
+  unsigned char *data = realloc(v->data, capacity * v->size);
+  assert(data != NULL);
+  v->data = data;
+  v->capacity = capacity;
+}
+
+Vector *initVector(deinitFunction deinit, size_t elementSize) {
+  assert(elementSize > 0);
+  Vector *v = calloc(1, sizeof(Vector));
+  assert(v != NULL);
+
+  v->deinit = deinit;
+  v->size = elementSize;
+  v->count = 0;
+  v->capacity = VECTOR_MIN_CAPACITY;
+  v->data = calloc(v->capacity, elementSize);
+  assert(v->data != NULL);
+
+  return v;
+}
+
+void deinitVector(Vector *v) {
+  assert(v != NULL);
+  vectorClear(v);
+  free(v->data);
+  free(v);
+}
+
+void vectorReserve(Vector *v, size_t capacity) {
+  assert(v != NULL);
+  if (capacity <= v->capacity) return;
+
+  size_t c = v->capacity;
+  while (c < capacity) {
+    c *= 2;
+  }
+  resize(v, c);
+}
+
+void vectorShrink(Vector *v) {
+  assert(v != NULL);
+  size_t c = v->count > VECTOR_MIN_CAPACITY ? v->count : VECTOR_MIN_CAPACITY;
+  if (c < v->capacity) {
+    resize(v, c);
+  }
+}
+
+void vectorClear(Vector *v) {
+  assert(v != NULL);
+  if (v->deinit != NULL) {
+    for (uint64_t i = 0; i < v->count; i++) {
+      v->deinit(slotRef(v, i));
+    }
+  }
+  v->count = 0;
+}
+
+// Modifiers
+void vectorPushBack(Vector *v, const void *element) {
+  assert(v != NULL);
+  assert(element != NULL);
+  if (v->count == v->capacity) {
+    vectorReserve(v, v->capacity * 2);
+  }
+  memcpy(slotRef(v, v->count), element, v->size);
+  v->count += 1;
+}
+
+void vectorPopBack(Vector *v, void *data) {
+  assert(v != NULL);
+  if (v->count == 0) return;
+  void *p = slotRef(v, v->count - 1);
+  if (data != NULL) {
+    memcpy(data, p, v->size);
+  } else if (v->deinit != NULL) {
+    v->deinit(p);
+  }
+  v->count -= 1;
+}
+
+void vectorPushBackN(Vector *v, const void *elements, size_t n) {
+  assert(v != NULL);
+  assert(elements != NULL || n == 0);
+  vectorReserve(v, v->count + n);
+  memcpy(slotRef(v, v->count), elements, n * v->size);
+  v->count += n;
+}
+
+void vectorSort(Vector *v, int (*compare)(const void *, const void *)) {
+  assert(v != NULL);
+  assert(compare != NULL);
+  qsort(v->data, v->count, v->size, compare);
+}
+
+// Accessors
+uint64_t vectorCount(Vector *v) {
+  assert(v != NULL);
+  return v->count;
+}
+
+bool vectorIsEmpty(Vector *v) {
+  assert(v != NULL);
+  return v->count == 0;
+}
+
+void *vectorAt(Vector *v, uint64_t i) {
+  assert(v != NULL);
+  if (i >= v->count) {
+    return NULL;
+  }
+  return slotRef(v, i);
+}
+
+void *vectorBack(Vector *v) {
+  assert(v != NULL);
+  if (v->count == 0) {
+    return NULL;
+  }
+  return slotRef(v, v->count - 1);
+}
+
+void *vectorData(Vector *v) {
+  assert(v != NULL);
+  return v->data;
+}
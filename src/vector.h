@@ -0,0 +1,56 @@
+#pragma once
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "list.h" // deinitFunction
+
+// Initial capacity of a vector, in elements
+#define VECTOR_MIN_CAPACITY 16
+
+typedef struct Vector {
+  // Number of elements on the vector
+  uint64_t count;
+  // Size of a data element
+  size_t size;
+  // Deinit function for data element
+  deinitFunction deinit;
+  // Buffer holding capacity contiguous elements
+  unsigned char *data;
+  // Number of slots in data
+  size_t capacity;
+} Vector;
+
+// Initializes vector
+// deinitFunction: Function to be called on elements dropped by the vector.
+// Elements live inline in the buffer, so it must not free the element itself.
+// elementSize: Size of the stored data element.
+Vector *initVector(deinitFunction deinit, size_t elementSize);
+// Frees up the vector and all its elements
+void deinitVector(Vector *v);
+
+// Makes room for at least capacity elements, doubling the buffer
+void vectorReserve(Vector *v, size_t capacity);
+// Releases the slots past the last element
+void vectorShrink(Vector *v);
+// Removes all elements, keeping the buffer
+void vectorClear(Vector *v);
+
+// Modifiers
+// Inserts element after the last element
+void vectorPushBack(Vector *v, const void *element);
+// Removes the last element.
+// Data is copied to the 'data' pointer, or deinitialized if it is NULL.
+void vectorPopBack(Vector *v, void *data);
+// Appends n contiguous elements, in order
+void vectorPushBackN(Vector *v, const void *elements, size_t n);
+// Sorts the elements with qsort() semantics for compare
+void vectorSort(Vector *v, int (*compare)(const void *, const void *));
+
+// Accessors
+uint64_t vectorCount(Vector *v);
+bool vectorIsEmpty(Vector *v);
+// Reference to the ith element, NULL if out of range
+void *vectorAt(Vector *v, uint64_t i);
+void *vectorBack(Vector *v);
+// The elements, contiguous, valid until the vector grows or shrinks
+void *vectorData(Vector *v);
@@ -0,0 +1,220 @@
+// mremap()
+#define _GNU_SOURCE
+#include "writer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <errno.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+
+writer *writer_stdio(writer *w, FILE *fp) {
+  assert(w);
+  assert(fp);
+  *w = (writer) {WRITER_STDIO, fp, -1, false, malloc(WRITER_BUFFER), 0, WRITER_BUFFER, false};
+  assert(w->buf);
+  return w;
+}
+
+writer *writer_fd(writer *w, int fd) {
+  assert(w);
+  *w = (writer) {WRITER_FD, NULL, fd, false, malloc(WRITER_BUFFER), 0, WRITER_BUFFER, false};
+  assert(w->buf);
+  return w;
+}
+
+bool writer_file(writer *w, const char *path) {
+  assert(w);
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return false;
+  writer_fd(w, fd)->owns_fd = true;
+  return true;
+}
+
+bool writer_mmap(writer *w, const char *path) {
+  assert(w);
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return false;
+  if (ftruncate(fd, WRITER_BUFFER) != 0) {
+    close(fd);
+    return false;
+  }
+  char *map = mmap(NULL, WRITER_BUFFER, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+  *w = (writer) {WRITER_MMAP, NULL, fd, true, map, 0, WRITER_BUFFER, false};
+  return true;
+}
+
+// Writes all n bytes of the iovecs to fd, retrying short writes
+static bool write_all(int fd, struct iovec *iov, int count) {
+  while (count > 0) {
+    ssize_t done = writev(fd, iov, count);
+    if (done < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    size_t left = (size_t) done;
+    while (count > 0 && left >= iov->iov_len) {
+      left -= iov->iov_len;
+      iov++;
+      count--;
+    }
+    if (count > 0) {
+      iov->iov_base = (char *) iov->iov_base + left;
+      iov->iov_len -= left;
+    }
+  }
+  return true;
+}
+
+void writer_flush(writer *w) {
+  assert(w);
+  if (w->kind == WRITER_MMAP || w->len == 0) return;
+  if (!w->failed) {
+    if (w->kind == WRITER_STDIO) {
+      w->failed = fwrite(w->buf, 1, w->len, w->fp) != w->len;
+    } else {
+      struct iovec iov = {w->buf, w->len};
+      w->failed = !write_all(w->fd, &iov, 1);
+    }
+  }
+  w->len = 0;
+}
+
+bool writer_close(writer *w) {
+  assert(w);
+  if (w->kind == WRITER_MMAP) {
+    munmap(w->buf, w->cap);
+    w->failed = w->failed || ftruncate(w->fd, (off_t) w->len) != 0;
+  } else {
+    writer_flush(w);
+    free(w->buf);
+  }
+  if (w->owns_fd) {
+    w->failed = close(w->fd) != 0 || w->failed;
+  }
+  w->buf = NULL;
+  w->len = w->cap = 0;
+  return !w->failed;
+}
+
+void writer_reserve(writer *w, size_t n) {
+  assert(w);
+  if (w->cap - w->len >= n) return;
+
+  if (w->kind != WRITER_MMAP) {
+    writer_flush(w);
+    if (n > w->cap) {
+      w->buf = realloc(w->buf, n);
+      assert(w->buf);
+      w->cap = n;
+    }
+    return;
+  }
+
+  // grow the file and its mapping, whole steps at a time
+  size_t cap = w->cap;
+  while (cap - w->len < n) {
+    cap += WRITER_BUFFER;
+  }
+  char *map = MAP_FAILED;
+  if (ftruncate(w->fd, (off_t) cap) == 0) {
+    map = mremap(w->buf, w->cap, cap, MREMAP_MAYMOVE);
+  }
+  if (map == MAP_FAILED) {
+    // keep going into the old mapping, the output is lost
+    w->failed = true;
+    w->len = 0;
+    assert(w->cap >= n);
+    return;
+  }
+  w->buf = map;
+  w->cap = cap;
+}
+
+void writer_bytes(writer *w, const void *data, size_t n) {
+  assert(w);
+  if (w->kind == WRITER_FD && n >= WRITER_BUFFER / 2) {
+    // the buffer and the block go out in one call, without a copy
+    if (!w->failed) {
+      struct iovec iov[2] = {{w->buf, w->len}, {(void *) data, n}};
+      w->failed = !write_all(w->fd, iov, 2);
+    }
+    w->len = 0;
+    return;
+  }
+  writer_reserve(w, n);
+  memcpy(w->buf + w->len, data, n);
+  w->len += n;
+}
+
+void writer_str(writer *w, const char *s) {
+  writer_bytes(w, s, strlen(s));
+}
+
+void writer_uint(writer *w, uint64_t x) {
+  char digits[20];
+  size_t n = 0;
+  do {
+    digits[n++] = (char) ('0' + x % 10);
+    x /= 10;
+  } while (x);
+  writer_reserve(w, n);
+  while (n) {
+    w->buf[w->len++] = digits[--n];
+  }
+}
+
+void writer_fixed(writer *w, double x) {
+  double a = fabs(x);
+  uint64_t units, micros;
+  if (a < 0x1p53 && a == floor(a)) {
+    units = (uint64_t) a;
+    micros = 0;
+  } else {
+    double scaled = a * 1e6;
+    double r = nearbyint(scaled);
+    if (!(a < WRITER_FIXED_LIMIT) || fabs(scaled - r) > 0.498) {
+      // too large or too close to a tie to round by hand
+      writer_printf(w, "%f", x);
+      return;
+    }
+    units = (uint64_t) r / 1000000;
+    micros = (uint64_t) r % 1000000;
+  }
+
+  if (signbit(x)) writer_char(w, '-');
+  writer_uint(w, units);
+  writer_reserve(w, 7);
+  w->buf[w->len++] = '.';
+  for (int i = 6; i > 0; i--) {
+    w->buf[w->len + (size_t) i - 1] = (char) ('0' + micros % 10);
+    micros /= 10;
+  }
+  w->len += 6;
+}
+
+void writer_printf(writer *w, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(w->buf + w->len, w->cap - w->len, format, args);
+  va_end(args);
+  assert(n >= 0);
+  if ((size_t) n < w->cap - w->len) {
+    w->len += (size_t) n;
+    return;
+  }
+
+  writer_reserve(w, (size_t) n + 1);
+  va_start(args, format);
+  vsnprintf(w->buf + w->len, w->cap - w->len, format, args);
+  va_end(args);
+  w->len += (size_t) n;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Size of the buffer of a writer, and the growth step of a mapped file
+#define WRITER_BUFFER (1 << 20)
+// Largest value writer_fixed() formats by hand when it is not integral.
+// Below it the product by 1e6 is off by less than 2^-10, so rounding
+// to six decimals matches printf unless the seventh is right at a tie.
+#define WRITER_FIXED_LIMIT 8e6
+
+// Where a writer's bytes go
+typedef enum writer_kind {
+  WRITER_STDIO, // fwrite() to a FILE, which keeps its own buffering
+  WRITER_FD,    // write() to a file descriptor, writev() for large blocks
+  WRITER_MMAP   // straight into a shared mapping of the output file
+} writer_kind;
+
+// Output buffer with hand written number formatting
+typedef struct writer {
+  writer_kind kind;
+  FILE *fp;
+  int fd;
+  // whether writer_close() closes fd
+  bool owns_fd;
+  // bytes not yet written, or the mapping of the output file
+  char *buf;
+  size_t len;
+  size_t cap;
+  // set once a write fails, later output is dropped
+  bool failed;
+} writer;
+
+// Writer flushing into fp
+writer *writer_stdio(writer *w, FILE *fp);
+// Writer flushing into fd, which it does not close
+writer *writer_fd(writer *w, int fd);
+// Writer creating or truncating the file at path and writing to it
+// with write(). Returns false if the file cannot be opened.
+bool writer_file(writer *w, const char *path);
+// Writer mapping the file at path, created or truncated. The file grows
+// by WRITER_BUFFER as it fills and is cut to size by writer_close().
+// Returns false if the file cannot be opened or mapped.
+bool writer_mmap(writer *w, const char *path);
+
+// Hands the buffered bytes to the FILE or the descriptor
+void writer_flush(writer *w);
+// Flushes and frees w. Returns false if any write failed.
+bool writer_close(writer *w);
+
+// Makes room for n more bytes in the buffer
+void writer_reserve(writer *w, size_t n);
+
+// n bytes from data. Large blocks skip the buffer.
+void writer_bytes(writer *w, const void *data, size_t n);
+void writer_str(writer *w, const char *s);
+void writer_uint(writer *w, uint64_t x);
+// x as printf's "%f" prints it
+void writer_fixed(writer *w, double x);
+// Formatted with printf, for anything else
+void writer_printf(writer *w, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static inline void writer_char(writer *w, char c) {
+  if (w->len == w->cap) writer_reserve(w, 1);
+  w->buf[w->len++] = c;
+}